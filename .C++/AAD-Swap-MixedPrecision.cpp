@@ -0,0 +1,564 @@
+// This file demo's a mixed precision (float32) batch mode for swap PV and DV01 risk using tangent mode AD
+// We price a batch of swaps at once, in double precision and in float precision, and certify the float results.
+
+// The pricers in AAD-Swap.cpp work on one swap at a time in double precision. For intraday indicative risk on very
+// large books we process the whole book in one batch kernel. The batch is stored as a structure of arrays (SoA), the
+// inner loop runs across trades so the compiler can vectorize it and each SIMD register holds one value per trade.
+// A SIMD register holds twice as many floats as doubles, so float32 doubles the SIMD width and halves the memory
+// traffic for the trade data.
+
+// Float has only ~7 significant digits (unit roundoff u = 2^-24 ~ 6e-8), so we:
+//   1. keep the leg sums in compensated (Kahan) form, so summation error does not grow with the number of coupons
+//   2. compute a per-trade rounding error bound for PV and DV01 from the static trade data, once when the book is
+//      split, valid for any zero rate in a band around the market, so the float kernel does no bound arithmetic
+//   3. price trades whose bound breaches the tolerance with the double precision kernel, e.g. large notionals
+//      The book is split once into float and double batches, so these trades are still priced by a batch kernel.
+//      When the market leaves the band the book is rebuilt and every trade is recertified.
+// Finally, we check that the actual float vs double error is within the bound for every trade.
+
+// The speed-up comes from the compiler vectorizing the trade loops, so build with g++ -O3 -march=native. With it, on
+// 200k swaps and an AVX-512 machine, the float kernel runs ~1.6x and the mixed book ~1.3x the double kernel. GCC does
+// not vectorize these loops at -O2, and then both kernels run at the same scalar speed.
+
+// Note: Do not compile with -ffast-math, it allows the compiler to remove the Kahan compensation terms.
+
+#include <cmath>    // for math methods e.g. exp()
+#include <vector>   // for vectors
+#include <chrono>   // for timing the batch kernels
+#include <cstdint>  // for fixed width integers
+#include <cstring>  // for memcpy()
+#include <iostream> // for input/output to console
+#include <iomanip>  // for input/output precision
+#include <algorithm> // for min(), max()
+using namespace std;
+
+// Vectorizable exponential functions
+// The standard library exp() is a function call that stops the compiler vectorizing the batch loops, so both
+// kernels use an inline exp: exp(x) = 2^n.exp(r) with r = x - n.ln(2), |r| <= ln(2)/2, and a Taylor polynomial
+// for exp(r). Valid for |x| < 80, which covers discount factors exp(-z.t).
+inline double exp_double(double x)
+{
+    const double magic = 6755399441055744.0;        // 1.5*2^52, adding it rounds to the nearest integer
+    double n = (x * 1.4426950408889634 + magic) - magic;
+    double r = (x - n * 0.6931471803691238) - n * 1.9082149292705877e-10;
+    double p = 1.0 / 479001600.0;                   // Taylor series to r^12, error < 2e-16
+    p = p * r + 1.0 / 39916800.0; p = p * r + 1.0 / 3628800.0; p = p * r + 1.0 / 362880.0;
+    p = p * r + 1.0 / 40320.0;    p = p * r + 1.0 / 5040.0;    p = p * r + 1.0 / 720.0;
+    p = p * r + 1.0 / 120.0;      p = p * r + 1.0 / 24.0;      p = p * r + 1.0 / 6.0;
+    p = p * r + 0.5;              p = p * r + 1.0;             p = p * r + 1.0;
+    int64_t bits = ((int64_t)n + 1023) << 52;       // 2^n
+    double scale;
+    memcpy(&scale, &bits, sizeof(scale));
+    return p * scale;
+}
+
+inline float exp_float(float x)
+{
+    const float magic = 12582912.0f;                // 1.5*2^23, adding it rounds to the nearest integer
+    float n = (x * 1.44269504f + magic) - magic;
+    float r = (x - n * 0.693359375f) + n * 2.12194440e-4f;
+    float p = 1.0f / 40320.0f;                      // Taylor series to r^8, error ~1 ulp
+    p = p * r + 1.0f / 5040.0f; p = p * r + 1.0f / 720.0f; p = p * r + 1.0f / 120.0f;
+    p = p * r + 1.0f / 24.0f;   p = p * r + 1.0f / 6.0f;   p = p * r + 0.5f;
+    p = p * r + 1.0f;           p = p * r + 1.0f;
+    int32_t bits = ((int32_t)n + 127) << 23;        // 2^n
+    float scale;
+    memcpy(&scale, &bits, sizeof(scale));
+    return p * scale;
+}
+
+// Trades per block in the batch kernels
+const size_t block_size = 512;
+
+// Swap batch stored as a structure of arrays. Coupon data is stored coupon by coupon, i.e. element [i*size+k]
+// holds coupon i of trade k, so the inner loop over trades reads contiguous memory.
+// For simplicity all trades have the same number of fixed and float coupons and df=exp(-z.t) for a constant zero rate z
+template <typename Real>
+struct SwapBatch
+{
+    size_t size = 0;            // Number of trades
+    size_t fixed_coupons = 0;   // Fixed coupons per trade
+    size_t float_coupons = 0;   // Float coupons per trade
+    vector<Real> payReceive;    // Pay or Receive Fixed: 1 = pay, -1 = receive
+    vector<Real> notional;      // Swap Notional
+    vector<Real> fixed_rate;    // Fixed Leg: fixed rate in decimal
+    vector<Real> fixed_tau;     // Fixed Leg: fixed coupon accrual year fractions [i*size+k]
+    vector<Real> fixed_t;       // Fixed Leg: fixed coupon payment time in years [i*size+k]
+    vector<Real> float_spread;  // Float Leg: floating spread in decimal
+    vector<Real> float_tau;     // Float Leg: float coupon accrual year fractions [j*size+k]
+    vector<Real> float_t;       // Float Leg: float coupon payment time in years [j*size+k]
+    vector<Real> float_rates;   // Float Leg: floating forward rates in decimal [j*size+k]
+};
+
+// Round a double batch to float, this is static trade data and is done once, not on every risk run
+SwapBatch<float> to_float(const SwapBatch<double>& b)
+{
+    SwapBatch<float> f;
+    f.size = b.size; f.fixed_coupons = b.fixed_coupons; f.float_coupons = b.float_coupons;
+    f.payReceive.assign(b.payReceive.begin(), b.payReceive.end());
+    f.notional.assign(b.notional.begin(), b.notional.end());
+    f.fixed_rate.assign(b.fixed_rate.begin(), b.fixed_rate.end());
+    f.fixed_tau.assign(b.fixed_tau.begin(), b.fixed_tau.end());
+    f.fixed_t.assign(b.fixed_t.begin(), b.fixed_t.end());
+    f.float_spread.assign(b.float_spread.begin(), b.float_spread.end());
+    f.float_tau.assign(b.float_tau.begin(), b.float_tau.end());
+    f.float_t.assign(b.float_t.begin(), b.float_t.end());
+    f.float_rates.assign(b.float_rates.begin(), b.float_rates.end());
+    return f;
+}
+
+// Compute swap PV and DV01 for the batch in double precision using tangent mode
+// As per swap_price_tangent_mode() in AAD-Swap.cpp with all forward rates and the zero rate shifted together
+void swap_batch_tangent_mode( const SwapBatch<double>& b,   // [IN]: Swap batch
+                              double zero_rate,             // [IN]: Discounting zero rate in decimal
+                              double float_rates_dot,       // [IN]: RISK INPUT - forward rate bump size, applied to all forwards
+                              double zero_rate_dot,         // [IN]: RISK INPUT - discounting risk, bump size for zero rate
+                              vector<double>& swap_pv,      // [OUT]: Swap PV per trade
+                              vector<double>& swap_pv_dot   // [OUT]: Swap risk per trade e.g. DV01
+                            )
+{
+    const size_t n = b.size;
+
+    // Trades are processed in blocks so the running sums stay in L1 cache
+    for (size_t k0 = 0; k0 < n; k0 += block_size)
+    {
+        const size_t m = min(block_size, n - k0);
+        double pv[block_size] = {}, pv_dot[block_size] = {};
+
+        // Fixed Leg PV
+        for (size_t i = 0; i < b.fixed_coupons; ++i)
+        {
+            const double* tau = &b.fixed_tau[i*n + k0];
+            const double* t = &b.fixed_t[i*n + k0];
+            const double* notional = &b.notional[k0];
+            const double* fixed_rate = &b.fixed_rate[k0];
+            for (size_t k = 0; k < m; ++k)
+            {
+                double df = exp_double(-zero_rate*t[k]);
+                double term = notional[k] * fixed_rate[k] * tau[k] * df;
+                pv[k] += term;
+                pv_dot[k] += -t[k] * term * zero_rate_dot;
+            }
+        }
+
+        // Float Leg PV
+        for (size_t j = 0; j < b.float_coupons; ++j)
+        {
+            const double* tau = &b.float_tau[j*n + k0];
+            const double* t = &b.float_t[j*n + k0];
+            const double* f = &b.float_rates[j*n + k0];
+            const double* notional = &b.notional[k0];
+            const double* float_spread = &b.float_spread[k0];
+            for (size_t k = 0; k < m; ++k)
+            {
+                double df = exp_double(-zero_rate*t[k]);
+                double annuity = notional[k] * tau[k] * df;
+                double term = annuity * (f[k] + float_spread[k]);
+                pv[k] -= term;
+                pv_dot[k] -= annuity * float_rates_dot - t[k] * term * zero_rate_dot;
+            }
+        }
+
+        // Swap PV
+        for (size_t k = 0; k < m; ++k)
+        {
+            swap_pv[k0 + k] = b.payReceive[k0 + k] * pv[k];
+            swap_pv_dot[k0 + k] = b.payReceive[k0 + k] * pv_dot[k];
+        }
+    }
+}
+
+// Gather a subset of the trades into a new batch, used to split the book into float and double precision batches
+SwapBatch<double> make_sub_batch(const SwapBatch<double>& b, const vector<size_t>& trades)
+{
+    SwapBatch<double> s;
+    const size_t n = b.size, m = trades.size();
+    s.size = m; s.fixed_coupons = b.fixed_coupons; s.float_coupons = b.float_coupons;
+    s.payReceive.resize(m); s.notional.resize(m); s.fixed_rate.resize(m); s.float_spread.resize(m);
+    s.fixed_tau.resize(b.fixed_coupons*m); s.fixed_t.resize(b.fixed_coupons*m);
+    s.float_tau.resize(b.float_coupons*m); s.float_t.resize(b.float_coupons*m); s.float_rates.resize(b.float_coupons*m);
+    for (size_t k = 0; k < m; ++k)
+    {
+        size_t src = trades[k];
+        s.payReceive[k] = b.payReceive[src]; s.notional[k] = b.notional[src];
+        s.fixed_rate[k] = b.fixed_rate[src]; s.float_spread[k] = b.float_spread[src];
+    }
+    for (size_t i = 0; i < b.fixed_coupons; ++i)
+    {
+        for (size_t k = 0; k < m; ++k)
+        {
+            s.fixed_tau[i*m+k] = b.fixed_tau[i*n+trades[k]];
+            s.fixed_t[i*m+k] = b.fixed_t[i*n+trades[k]];
+        }
+    }
+    for (size_t j = 0; j < b.float_coupons; ++j)
+    {
+        for (size_t k = 0; k < m; ++k)
+        {
+            s.float_tau[j*m+k] = b.float_tau[j*n+trades[k]];
+            s.float_t[j*m+k] = b.float_t[j*n+trades[k]];
+            s.float_rates[j*m+k] = b.float_rates[j*n+trades[k]];
+        }
+    }
+    return s;
+}
+
+// Kahan compensated summation: sum += x, the rounding error of each addition is carried in comp
+inline void kahan_add(float& sum, float& comp, float x)
+{
+    float y = x - comp;
+    float s = sum + y;
+    comp = (s - sum) - y;
+    sum = s;
+}
+
+// Rounding error bound of the float kernel per trade, valid for any zero rate in [zero_rate_lo, zero_rate_hi]
+// The bound only depends on the static trade data and the zero rate band, so it is computed once when the book is
+// split rather than inside the float kernel, which then does no bound arithmetic per coupon.
+
+// Error Bound
+// Each coupon term e.g. N.r.tau.exp(-z.t) is computed from float inputs with a handful of roundings, giving a
+// relative error of at most c_term.u + c_exp.u.|z.t| where the second part is the error in the exponent argument
+// amplified by exp(). We use c_term = 10 (3 inputs, 3 products, exp_float ~2 ulp, risk products) plus 2 for the
+// compensated sum, which adds at most 2u of the absolute sum, and c_exp = 3. Over the band |term| is largest at the
+// lowest zero rate and |z.t| at the zero rate furthest from 0. The bound is first order in u, so we scale it by 2.
+void swap_batch_error_bound( const SwapBatch<double>& b,    // [IN]: Swap batch
+                             double zero_rate_lo,           // [IN]: Lowest discounting zero rate the bound is valid for
+                             double zero_rate_hi,           // [IN]: Highest discounting zero rate the bound is valid for
+                             double float_rates_dot,        // [IN]: RISK INPUT - forward rate bump size, applied to all forwards
+                             double zero_rate_dot,          // [IN]: RISK INPUT - discounting risk, bump size for zero rate
+                             vector<double>& pv_bound,      // [OUT]: Rounding error bound on float swap PV per trade
+                             vector<double>& pv_dot_bound   // [OUT]: Rounding error bound on float swap risk per trade
+                           )
+{
+    const size_t n = b.size;
+    const double u = 5.9604645e-8; // float unit roundoff 2^-24
+    const double c_term = 10.0 + 2.0, c_exp = 3.0, safety = 2.0;
+    const double z_max = max(fabs(zero_rate_lo), fabs(zero_rate_hi));
+    pv_bound.assign(n, 0.0);
+    pv_dot_bound.assign(n, 0.0);
+
+    // Fixed Leg
+    for (size_t i = 0; i < b.fixed_coupons; ++i)
+    {
+        for (size_t k = 0; k < n; ++k)
+        {
+            double t = b.fixed_t[i*n+k];
+            double rel = safety * u * (c_term + c_exp * z_max * t);
+            double term = fabs(b.notional[k] * b.fixed_rate[k] * b.fixed_tau[i*n+k]) * exp(-zero_rate_lo * t);
+            pv_bound[k] += term * rel;
+            pv_dot_bound[k] += t * term * fabs(zero_rate_dot) * rel;
+        }
+    }
+
+    // Float Leg
+    for (size_t j = 0; j < b.float_coupons; ++j)
+    {
+        for (size_t k = 0; k < n; ++k)
+        {
+            double t = b.float_t[j*n+k];
+            double rel = safety * u * (c_term + c_exp * z_max * t);
+            double annuity = fabs(b.notional[k] * b.float_tau[j*n+k]) * exp(-zero_rate_lo * t);
+            double term = annuity * fabs(b.float_rates[j*n+k] + b.float_spread[k]);
+            pv_bound[k] += term * rel;
+            pv_dot_bound[k] += (annuity * fabs(float_rates_dot) + t * term * fabs(zero_rate_dot)) * rel;
+        }
+    }
+}
+
+// Compute swap PV and DV01 for the batch in float precision using tangent mode
+// The swap sums are accumulated with compensated summation, the error bound comes from swap_batch_error_bound()
+void swap_batch_tangent_mode_float( const SwapBatch<float>& b,     // [IN]: Swap batch in float precision
+                                    float zero_rate,               // [IN]: Discounting zero rate in decimal
+                                    float float_rates_dot,         // [IN]: RISK INPUT - forward rate bump size, applied to all forwards
+                                    float zero_rate_dot,           // [IN]: RISK INPUT - discounting risk, bump size for zero rate
+                                    vector<double>& swap_pv,       // [OUT]: Swap PV per trade
+                                    vector<double>& swap_pv_dot    // [OUT]: Swap risk per trade e.g. DV01
+                                  )
+{
+    const size_t n = b.size;
+
+    // Trades are processed in blocks so the running sums stay in L1 cache
+    for (size_t k0 = 0; k0 < n; k0 += block_size)
+    {
+        const size_t m = min(block_size, n - k0);
+
+        // Swap sums and compensation terms, fixed minus float is accumulated directly into one sum per output
+        float pv[block_size] = {}, pv_comp[block_size] = {}, pv_dot[block_size] = {}, pv_dot_comp[block_size] = {};
+
+        // Fixed Leg PV
+        for (size_t i = 0; i < b.fixed_coupons; ++i)
+        {
+            const float* tau = &b.fixed_tau[i*n + k0];
+            const float* t = &b.fixed_t[i*n + k0];
+            const float* notional = &b.notional[k0];
+            const float* fixed_rate = &b.fixed_rate[k0];
+            for (size_t k = 0; k < m; ++k)
+            {
+                float df = exp_float(-zero_rate*t[k]);
+                float term = notional[k] * fixed_rate[k] * tau[k] * df;
+                kahan_add(pv[k], pv_comp[k], term);
+                kahan_add(pv_dot[k], pv_dot_comp[k], -t[k] * term * zero_rate_dot);
+            }
+        }
+
+        // Float Leg PV
+        for (size_t j = 0; j < b.float_coupons; ++j)
+        {
+            const float* tau = &b.float_tau[j*n + k0];
+            const float* t = &b.float_t[j*n + k0];
+            const float* f = &b.float_rates[j*n + k0];
+            const float* notional = &b.notional[k0];
+            const float* float_spread = &b.float_spread[k0];
+            for (size_t k = 0; k < m; ++k)
+            {
+                float df = exp_float(-zero_rate*t[k]);
+                float annuity = notional[k] * tau[k] * df;
+                float term = annuity * (f[k] + float_spread[k]);
+                kahan_add(pv[k], pv_comp[k], -term);
+                kahan_add(pv_dot[k], pv_dot_comp[k], t[k] * term * zero_rate_dot - annuity * float_rates_dot);
+            }
+        }
+
+        // Swap PV, results are returned in double so they can be aggregated with the double precision trades
+        for (size_t k = 0; k < m; ++k)
+        {
+            swap_pv[k0 + k] = b.payReceive[k0 + k] * ((double)pv[k] - (double)pv_comp[k]);
+            swap_pv_dot[k0 + k] = b.payReceive[k0 + k] * ((double)pv_dot[k] - (double)pv_dot_comp[k]);
+        }
+    }
+}
+
+// Mixed Precision Book
+// Gathering trades on every risk run would cost as much as pricing them, so the book is split once into a float
+// batch and a double batch. The error bounds are certified for a band of zero rates around the market at the split,
+// so a risk run inside the band only prices the two batches. When the market leaves the band the book is rebuilt,
+// which recertifies every trade and moves any trade whose bound now breaches the tolerance to the double batch.
+struct MixedPrecisionBook
+{
+    double zero_rate_lo = 0.0;      // Zero rate band the float error bounds are certified for
+    double zero_rate_hi = 0.0;
+    double band = 0.0;              // Half width of the band, used when the book is rebuilt
+    double pv_tolerance = 0.0;      // Maximum PV error bound accepted from float
+    double dv01_tolerance = 0.0;    // Maximum DV01 error bound accepted from float
+
+    SwapBatch<float> float_batch;   // Trades certified for float precision
+    vector<size_t> float_trades;    // Book index of each float trade
+    vector<double> float_pv_bound;  // PV error bound of each float trade over the band
+    vector<double> float_dv01_bound;// DV01 error bound of each float trade over the band
+    SwapBatch<double> double_batch; // Trades that need double precision
+    vector<size_t> double_trades;   // Book index of each double trade
+
+    // Result buffers, kept between risk runs to avoid reallocating them
+    vector<double> float_pv, float_dv01, double_pv, double_dv01;
+};
+
+MixedPrecisionBook build_mixed_book( const SwapBatch<double>& batch,   // [IN]: Swap book in double precision
+                                     double zero_rate,                 // [IN]: Discounting zero rate in decimal
+                                     double band,                      // [IN]: Certify the bounds for zero_rate +/- band
+                                     double pv_tolerance,              // [IN]: Maximum PV error bound accepted from float
+                                     double dv01_tolerance             // [IN]: Maximum DV01 error bound accepted from float
+                                   )
+{
+    const double shift = 0.0001;
+    MixedPrecisionBook book;
+    book.zero_rate_lo = zero_rate - band;
+    book.zero_rate_hi = zero_rate + band;
+    book.band = band;
+    book.pv_tolerance = pv_tolerance;
+    book.dv01_tolerance = dv01_tolerance;
+
+    vector<double> pv_bound, dv01_bound;
+    swap_batch_error_bound(batch, book.zero_rate_lo, book.zero_rate_hi, shift, shift, pv_bound, dv01_bound);
+    for (size_t k = 0; k < batch.size; ++k)
+    {
+        if (pv_bound[k] > pv_tolerance || dv01_bound[k] > dv01_tolerance) book.double_trades.push_back(k);
+        else
+        {
+            book.float_trades.push_back(k);
+            book.float_pv_bound.push_back(pv_bound[k]);
+            book.float_dv01_bound.push_back(dv01_bound[k]);
+        }
+    }
+    book.float_batch = to_float(make_sub_batch(batch, book.float_trades));
+    book.double_batch = make_sub_batch(batch, book.double_trades);
+
+    const size_t nf = book.float_trades.size(), nd = book.double_trades.size();
+    book.float_pv.resize(nf); book.float_dv01.resize(nf);
+    book.double_pv.resize(nd); book.double_dv01.resize(nd);
+    return book;
+}
+
+// Mixed precision risk run: float kernel for certified trades, double kernel for the rest
+// If the market has left the certified band the book is rebuilt first. Returns true if the book was rebuilt.
+bool swap_book_risk_mixed( MixedPrecisionBook& book,        // [IN/OUT]: Book split into float and double batches
+                           const SwapBatch<double>& batch,  // [IN]: Swap book in double precision, for rebuilds
+                           double zero_rate,                // [IN]: Discounting zero rate in decimal
+                           vector<double>& swap_pv,         // [OUT]: Swap PV per trade
+                           vector<double>& swap_dv01,       // [OUT]: Swap DV01 per trade
+                           vector<double>& pv_bound,        // [OUT]: PV error bound per trade, 0 for double trades
+                           vector<double>& dv01_bound       // [OUT]: DV01 error bound per trade, 0 for double trades
+                         )
+{
+    const double shift = 0.0001; // 1bp shift of all forwards and the zero rate, i.e. DV01
+
+    bool rebuilt = false;
+    if (zero_rate < book.zero_rate_lo || zero_rate > book.zero_rate_hi)
+    {
+        book = build_mixed_book(batch, zero_rate, book.band, book.pv_tolerance, book.dv01_tolerance);
+        rebuilt = true;
+    }
+    const size_t nf = book.float_trades.size(), nd = book.double_trades.size();
+
+    // 1. Float Batch
+    vector<double>& pv = book.float_pv;
+    vector<double>& dv01 = book.float_dv01;
+    swap_batch_tangent_mode_float(book.float_batch, (float)zero_rate, (float)shift, (float)shift, pv, dv01);
+    for (size_t f = 0; f < nf; ++f)
+    {
+        size_t k = book.float_trades[f];
+        swap_pv[k] = pv[f];
+        swap_dv01[k] = dv01[f];
+        pv_bound[k] = book.float_pv_bound[f];
+        dv01_bound[k] = book.float_dv01_bound[f];
+    }
+
+    // 2. Double Batch
+    vector<double>& pv_double = book.double_pv;
+    vector<double>& dv01_double = book.double_dv01;
+    swap_batch_tangent_mode(book.double_batch, zero_rate, shift, shift, pv_double, dv01_double);
+    for (size_t d = 0; d < nd; ++d)
+    {
+        size_t k = book.double_trades[d];
+        swap_pv[k] = pv_double[d];
+        swap_dv01[k] = dv01_double[d];
+        pv_bound[k] = 0.0;
+        dv01_bound[k] = 0.0;
+    }
+    return rebuilt;
+}
+
+// Build a batch of 5Y swaps, annual fixed vs quarterly float, with a range of notionals, rates and start dates
+SwapBatch<double> make_batch(size_t size)
+{
+    SwapBatch<double> b;
+    b.size = size; b.fixed_coupons = 5; b.float_coupons = 20;
+    b.payReceive.resize(size); b.notional.resize(size); b.fixed_rate.resize(size); b.float_spread.resize(size);
+    b.fixed_tau.resize(b.fixed_coupons*size); b.fixed_t.resize(b.fixed_coupons*size);
+    b.float_tau.resize(b.float_coupons*size); b.float_t.resize(b.float_coupons*size); b.float_rates.resize(b.float_coupons*size);
+
+    unsigned int seed = 12345;
+    auto uniform = [&seed]() { seed = seed * 1664525u + 1013904223u; return (seed >> 8) / 16777216.0; };
+
+    for (size_t k = 0; k < size; ++k)
+    {
+        b.payReceive[k] = (k % 2) ? 1.0 : -1.0;
+        b.notional[k] = 1000000.0 * pow(10.0, 3.0 * pow(uniform(), 4.0));        // USD 1m to 1bn, mostly small tickets
+        b.fixed_rate[k] = 0.01 + 0.04 * uniform();
+        b.float_spread[k] = 0.0;
+        double start = uniform();                                               // forward start within a year
+        for (size_t i = 0; i < b.fixed_coupons; ++i)
+        {
+            b.fixed_tau[i*size+k] = 1.0 + 0.01 * uniform();                     // 30/360 or ACT/360 style year fractions
+            b.fixed_t[i*size+k] = start + i + 1.0;
+        }
+        for (size_t j = 0; j < b.float_coupons; ++j)
+        {
+            b.float_tau[j*size+k] = 0.25 + 0.005 * uniform();
+            b.float_t[j*size+k] = start + 0.25 * (j + 1);
+            b.float_rates[j*size+k] = 0.02 + 0.0005 * j;                        // upward sloping forwards
+        }
+    }
+    return b;
+}
+
+int main()
+{
+    double zero_rate = 0.015;           // Zero Rate, 1.5%
+    double band = 0.0050;               // Float error bounds are certified for the zero rate +/- 50bps
+    const size_t book_size = 200000;    // Number of swaps in the batch
+    const int repeats = 20;             // Risk runs to time
+
+    // Indicative risk tolerances: float results are accepted if their error bound is within these
+    double pv_tolerance = 10.00;        // USD 10.00 PV accuracy
+    double dv01_tolerance = 0.05;       // USD 0.05 DV01 accuracy
+
+    SwapBatch<double> batch = make_batch(book_size);
+    SwapBatch<float> batch_float = to_float(batch);
+
+    vector<double> pv(book_size), dv01(book_size);
+    vector<double> pv_mixed(book_size), dv01_mixed(book_size), pv_bound(book_size), dv01_bound(book_size);
+
+    // 1. Double Precision Batch
+    auto t0 = chrono::steady_clock::now();
+    for (int r = 0; r < repeats; ++r)
+        swap_batch_tangent_mode(batch, zero_rate, 0.0001, 0.0001, pv, dv01);
+    auto t1 = chrono::steady_clock::now();
+
+    // 2. Float Precision Batch, every trade in float
+    vector<double> pv_float(book_size), dv01_float(book_size), pv_float_bound, dv01_float_bound;
+    auto t2 = chrono::steady_clock::now();
+    for (int r = 0; r < repeats; ++r)
+        swap_batch_tangent_mode_float(batch_float, (float)zero_rate, 0.0001f, 0.0001f, pv_float, dv01_float);
+    auto t3 = chrono::steady_clock::now();
+    swap_batch_error_bound(batch, zero_rate - band, zero_rate + band, 0.0001, 0.0001, pv_float_bound, dv01_float_bound);
+
+    // 3. Mixed Precision Book - certified float trades, the rest in double
+    // The book is split at the current market and then priced after a small market move (zero rate +1.5bps)
+    auto t4 = chrono::steady_clock::now();
+    MixedPrecisionBook mixed_book = build_mixed_book(batch, zero_rate, band, pv_tolerance, dv01_tolerance);
+    auto t5 = chrono::steady_clock::now();
+    for (int r = 0; r < repeats; ++r)
+        swap_book_risk_mixed(mixed_book, batch, zero_rate * 1.01, pv_mixed, dv01_mixed, pv_bound, dv01_bound);
+    auto t6 = chrono::steady_clock::now();
+
+    // Double precision reference after the market move
+    vector<double> pv_moved(book_size), dv01_moved(book_size);
+    swap_batch_tangent_mode(batch, zero_rate * 1.01, 0.0001, 0.0001, pv_moved, dv01_moved);
+
+    // 4. Certification: the float error vs the double path must be within the bound for every trade
+    size_t bound_failures = 0;
+    double max_pv_error = 0.0, max_dv01_error = 0.0, max_pv_bound = 0.0, max_dv01_bound = 0.0;
+    for (size_t k = 0; k < book_size; ++k)
+    {
+        if (fabs(pv_float[k] - pv[k]) > pv_float_bound[k] || fabs(dv01_float[k] - dv01[k]) > dv01_float_bound[k]) ++bound_failures;
+        if (fabs(pv_mixed[k] - pv_moved[k]) > pv_bound[k] || fabs(dv01_mixed[k] - dv01_moved[k]) > dv01_bound[k]) ++bound_failures;
+        max_pv_error = max(max_pv_error, fabs(pv_mixed[k] - pv_moved[k]));
+        max_dv01_error = max(max_dv01_error, fabs(dv01_mixed[k] - dv01_moved[k]));
+        max_pv_bound = max(max_pv_bound, pv_bound[k]);
+        max_dv01_bound = max(max_dv01_bound, dv01_bound[k]);
+    }
+
+    // 5. A large market move (zero rate +100bps) leaves the certified band, the book is rebuilt and recertified
+    size_t double_before = mixed_book.double_trades.size();
+    bool rebuilt = swap_book_risk_mixed(mixed_book, batch, zero_rate + 0.01, pv_mixed, dv01_mixed, pv_bound, dv01_bound);
+    swap_batch_tangent_mode(batch, zero_rate + 0.01, 0.0001, 0.0001, pv_moved, dv01_moved);
+    for (size_t k = 0; k < book_size; ++k)
+        if (fabs(pv_mixed[k] - pv_moved[k]) > pv_bound[k] || fabs(dv01_mixed[k] - dv01_moved[k]) > dv01_bound[k]) ++bound_failures;
+
+    double ms_double = chrono::duration<double, milli>(t1 - t0).count() / repeats;
+    double ms_float = chrono::duration<double, milli>(t3 - t2).count() / repeats;
+    double ms_build = chrono::duration<double, milli>(t5 - t4).count();
+    double ms_mixed = chrono::duration<double, milli>(t6 - t5).count() / repeats;
+
+    cout << "Mixed Precision Batch Risk" << endl;
+    cout << "Batch: " << book_size << " x 5Y swaps, annual fixed vs quarterly float" << endl;
+    cout << "Tolerance: PV " << std::fixed << std::setprecision(2) << pv_tolerance << ", DV01 " << dv01_tolerance << endl;
+    cout << endl;
+
+    cout << "Timings per risk run (PV + DV01)" << endl;
+    cout << "Double: " << std::fixed << std::setprecision(3) << ms_double << " ms, " << std::setprecision(1) << book_size / ms_double / 1000.0 << "m trades/sec" << endl;
+    cout << "Float:  " << std::fixed << std::setprecision(3) << ms_float << " ms, " << std::setprecision(1) << book_size / ms_float / 1000.0 << "m trades/sec, speed-up " << std::setprecision(2) << ms_double / ms_float << "x" << endl;
+    cout << "Mixed:  " << std::fixed << std::setprecision(3) << ms_mixed << " ms, " << std::setprecision(1) << book_size / ms_mixed / 1000.0 << "m trades/sec, speed-up " << std::setprecision(2) << ms_double / ms_mixed << "x" << endl;
+    cout << "Mixed book split and certification, once per band: " << std::setprecision(3) << ms_build << " ms" << endl;
+    cout << endl;
+
+    cout << "Accuracy (mixed vs double)" << endl;
+    cout << "Trades in double precision: " << double_before << " (" << std::fixed << std::setprecision(2) << 100.0 * double_before / book_size << "%)" << endl;
+    cout << "Max PV error:   " << std::scientific << std::setprecision(2) << max_pv_error << " (max bound " << max_pv_bound << ")" << endl;
+    cout << "Max DV01 error: " << std::scientific << std::setprecision(2) << max_dv01_error << " (max bound " << max_dv01_bound << ")" << endl;
+    cout << "After a 100bps move: book " << (rebuilt ? "rebuilt" : "not rebuilt") << ", trades in double precision: " << mixed_book.double_trades.size() << endl;
+    cout << "Float trades outside their error bound: " << bound_failures << endl;
+
+    return 0;
+}
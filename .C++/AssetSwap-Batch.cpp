@@ -0,0 +1,349 @@
+// This file demo's how to solve asset swap spreads for a bond inventory in one batch, with adjoint sensitivities
+// We support par-par and market-value asset swaps and compute each spread's risk to the bond price and curve pillars.
+
+// In an asset swap the investor buys a fixed coupon bond and swaps its coupons into float + spread:
+//   - par-par:      the package costs par, the upfront P - 1 is paid on the swap, float notional = 1
+//   - market-value: the package costs the dirty price P, notional (1 - P) is exchanged at maturity, float notional = P
+// Pricing the bond cashflows on the swap curve gives P_curve = sum c.tau.df(t) + df(T), and with the float leg annuity
+// A = sum tau.df(t) the spreads follow analytically, no root search is needed:
+//   par-par spread      s = (P_curve - P) / A
+//   market-value spread s = (P_curve - P) / (P.A)
+
+// The credit desk reprices its whole inventory on every curve tick, so the bonds are stored as one batch:
+//   - the bond and float leg cashflows of all bonds are flattened into structure-of-arrays, built once
+//   - the curve interpolation bucket and weight of every cashflow time is cached too, the pillars do not move
+//   - a curve tick then costs one exp() per cashflow, and the adjoint sweep gives every spread's sensitivity to
+//     the bond price and to all curve pillars for about the cost of a second pricing
+
+#include <cmath>         // for math methods e.g. exp()
+#include <vector>        // for vectors
+#include <algorithm>     // for upper_bound()
+#include <chrono>        // for timing
+#include <iostream>      // for input/output to console
+#include <iomanip>       // for input/output precision
+using namespace std;
+
+// Yield Curve
+// -----------
+// Zero rates at pillar times, linearly interpolated with flat extrapolation, df(t) = exp(-z(t).t)
+// The pillars are also the risk buckets
+struct Curve
+{
+    vector<double> pillar_t;    // Pillar times in years
+    vector<double> zero_rate;   // Zero rates in decimal
+};
+
+// Locate t on the curve: z(t) = w.zero_rate[k] + (1-w).zero_rate[k+1]
+void curve_weights(const Curve& curve, double t, size_t& k, double& w)
+{
+    const vector<double>& x = curve.pillar_t;
+    if (t <= x.front()) { k = 0; w = 1.0; return; }
+    if (t >= x.back())  { k = x.size() - 2; w = 0.0; return; }
+    k = (upper_bound(x.begin(), x.end(), t) - x.begin()) - 1;
+    w = (x[k+1] - t) / (x[k+1] - x[k]);
+}
+
+// Bonds
+// -----
+struct Bond
+{
+    double coupon;              // Annual coupon rate in decimal
+    int frequency;              // Coupons per year
+    double maturity;            // Maturity in years from settlement
+    double dirty_price;         // Market dirty price per unit notional
+};
+
+enum class AssetSwapType { ParPar, MarketValue };
+
+// Cashflows of all bonds, flattened, built once
+// Bond i owns bond cashflows [bond_begin[i], bond_begin[i+1]) and float leg periods [float_begin[i], float_begin[i+1])
+struct AssetSwapBatch
+{
+    size_t num_bonds = 0;
+    size_t num_pillars = 0;
+
+    vector<size_t> bond_begin;
+    vector<double> bond_t;          // Bond cashflow times
+    vector<double> bond_amount;     // Coupon c.tau, plus the redemption at maturity
+    vector<int>    bond_k;          // Cached curve bucket of the cashflow time
+    vector<double> bond_w;          // Cached curve weight of the cashflow time
+
+    vector<size_t> float_begin;
+    vector<double> float_t;         // Float leg payment times
+    vector<double> float_tau;       // Float leg accrual year fractions
+    vector<int>    float_k;
+    vector<double> float_w;
+
+    vector<double> bond_df;         // Scratch: discount factors from the forward sweep, reused by the adjoint
+    vector<double> float_df;
+};
+
+// Build the batch from the bonds: bond coupons at the bond frequency and quarterly float periods, both rolled back
+// from maturity so any stub is at the front
+AssetSwapBatch build_asset_swap_batch(const vector<Bond>& bonds, const Curve& curve, int float_frequency)
+{
+    AssetSwapBatch batch;
+    batch.num_bonds = bonds.size();
+    batch.num_pillars = curve.pillar_t.size();
+
+    auto add_flow = [&](vector<double>& t, vector<int>& k, vector<double>& w, double time) {
+        size_t kk; double ww;
+        curve_weights(curve, time, kk, ww);
+        t.push_back(time); k.push_back((int)kk); w.push_back(ww);
+    };
+
+    for (const Bond& bond : bonds)
+    {
+        batch.bond_begin.push_back(batch.bond_t.size());
+        const double tau = 1.0 / bond.frequency;
+        for (double t = bond.maturity; t > 1e-9; t -= tau)
+        {
+            add_flow(batch.bond_t, batch.bond_k, batch.bond_w, t);
+            batch.bond_amount.push_back(bond.coupon * tau + (t == bond.maturity ? 1.0 : 0.0));
+        }
+
+        batch.float_begin.push_back(batch.float_t.size());
+        const double float_tau = 1.0 / float_frequency;
+        for (double t = bond.maturity; t > 1e-9; t -= float_tau)
+        {
+            add_flow(batch.float_t, batch.float_k, batch.float_w, t);
+            batch.float_tau.push_back(min(float_tau, t));     // front stub accrues from settlement
+        }
+    }
+    batch.bond_begin.push_back(batch.bond_t.size());
+    batch.float_begin.push_back(batch.float_t.size());
+    batch.bond_df.resize(batch.bond_t.size());
+    batch.float_df.resize(batch.float_t.size());
+    return batch;
+}
+
+// Asset swap spreads and their risk, per bond
+struct AssetSwapResults
+{
+    vector<double> spread;          // Asset swap spread in decimal
+    vector<double> spread_price;    // d spread / d dirty price
+    vector<double> spread_zero;     // d spread / d zero rate, [bond * num_pillars + pillar]
+};
+
+// Compute the asset swap spreads and their sensitivities to the bond prices and curve pillars using adjoint mode
+void asset_swap_batch_adjoint_mode( AssetSwapBatch& batch,          // [IN]: Bond batch, df scratch is overwritten
+                                    const Curve& curve,             // [IN]: Swap curve
+                                    const vector<double>& prices,   // [IN]: Bond dirty prices per unit notional
+                                    AssetSwapType type,             // [IN]: Par-par or market-value
+                                    bool compute_risk,              // [IN]: false = spreads only
+                                    AssetSwapResults& res           // [OUT]: Spreads and risk
+                                  )
+{
+    const size_t n = batch.num_bonds, p = batch.num_pillars;
+    if (prices.size() != n)                 { cout << "Asset Swap Error: Wrong number of prices" << endl; return; }
+    if (curve.zero_rate.size() != p)        { cout << "Asset Swap Error: Curve pillars do not match the batch" << endl; return; }
+    const double* z = curve.zero_rate.data();
+
+    res.spread.resize(n);
+    if (compute_risk) { res.spread_price.resize(n); res.spread_zero.assign(n * p, 0.0); }
+
+    // Forward Sweep for Price
+    // -----------------------
+
+    // STEP 1: Discount factors of every cashflow in the batch, one flat vectorizable loop per leg
+    for (size_t j = 0; j < batch.bond_t.size(); ++j)
+    {
+        int k = batch.bond_k[j]; double w = batch.bond_w[j];
+        batch.bond_df[j] = exp(-(w * z[k] + (1.0 - w) * z[k+1]) * batch.bond_t[j]);
+    }
+    for (size_t j = 0; j < batch.float_t.size(); ++j)
+    {
+        int k = batch.float_k[j]; double w = batch.float_w[j];
+        batch.float_df[j] = exp(-(w * z[k] + (1.0 - w) * z[k+1]) * batch.float_t[j]);
+    }
+
+    for (size_t i = 0; i < n; ++i)
+    {
+        // STEP 2: Bond PV on the swap curve
+        double bond_pv = 0.0;
+        for (size_t j = batch.bond_begin[i]; j < batch.bond_begin[i+1]; ++j) bond_pv += batch.bond_amount[j] * batch.bond_df[j];
+
+        // STEP 3: Float leg annuity
+        double annuity = 0.0;
+        for (size_t j = batch.float_begin[i]; j < batch.float_begin[i+1]; ++j) annuity += batch.float_tau[j] * batch.float_df[j];
+
+        // STEP 4: Asset swap spread
+        double price = prices[i];
+        double par_spread = (bond_pv - price) / annuity;
+        res.spread[i] = type == AssetSwapType::ParPar ? par_spread : par_spread / price;
+        if (!compute_risk) continue;
+
+        // Back Propagation for Risk
+        // -------------------------
+
+        // STEP 4: Asset swap spread, seed spread_bar = 1
+        double par_spread_bar = 1.0, price_bar = 0.0;
+        if (type == AssetSwapType::MarketValue)
+        {
+            par_spread_bar = 1.0 / price;
+            price_bar = -par_spread / (price * price);
+        }
+        double bond_pv_bar = par_spread_bar / annuity;
+        double annuity_bar = -par_spread_bar * par_spread / annuity;
+        price_bar -= par_spread_bar / annuity;
+        res.spread_price[i] = price_bar;
+
+        // STEP 3 & 2: Leg discount factors to pillar zero rates, df = exp(-z.t), z = w.z[k] + (1-w).z[k+1]
+        double* zero_bar = &res.spread_zero[i * p];
+        for (size_t j = batch.bond_begin[i]; j < batch.bond_begin[i+1]; ++j)
+        {
+            double z_bar = -batch.bond_t[j] * batch.bond_df[j] * batch.bond_amount[j] * bond_pv_bar;
+            zero_bar[batch.bond_k[j]] += batch.bond_w[j] * z_bar;
+            zero_bar[batch.bond_k[j] + 1] += (1.0 - batch.bond_w[j]) * z_bar;
+        }
+        for (size_t j = batch.float_begin[i]; j < batch.float_begin[i+1]; ++j)
+        {
+            double z_bar = -batch.float_t[j] * batch.float_df[j] * batch.float_tau[j] * annuity_bar;
+            zero_bar[batch.float_k[j]] += batch.float_w[j] * z_bar;
+            zero_bar[batch.float_k[j] + 1] += (1.0 - batch.float_w[j]) * z_bar;
+        }
+    }
+}
+
+// Dirty price of a bond from its z-spread over the curve, one cashflow at a time: P = sum c.tau.df(t).exp(-zs.t) + ...
+// Independent of the batch, used to set the market prices
+double bond_price_z_spread(const Bond& bond, const Curve& curve, double z_spread)
+{
+    const double tau = 1.0 / bond.frequency;
+    double price = 0.0;
+    for (double t = bond.maturity; t > 1e-9; t -= tau)
+    {
+        size_t k; double w;
+        curve_weights(curve, t, k, w);
+        double zero = w * curve.zero_rate[k] + (1.0 - w) * curve.zero_rate[k+1];
+        double cashflow = bond.coupon * tau + (t == bond.maturity ? 1.0 : 0.0);
+        price += cashflow * exp(-(zero + z_spread) * t);
+    }
+    return price;
+}
+
+// Simple random number generator, uniform on [0,1)
+unsigned int seed = 12345;
+double uniform()
+{
+    seed = seed * 1664525u + 1013904223u;
+    return (seed >> 8) / 16777216.0;
+}
+
+int main()
+{
+    // 1. Market: swap curve
+    Curve curve;
+    curve.pillar_t  = { 0.25, 0.5, 1, 2, 3, 5, 7, 10, 15, 20, 30 };
+    curve.zero_rate = { 0.0430, 0.0420, 0.0400, 0.0380, 0.0370, 0.0365, 0.0370, 0.0380, 0.0390, 0.0395, 0.0390 };
+    const size_t p = curve.pillar_t.size();
+
+    // 2. Inventory: bonds priced off the curve at a known z-spread
+    const size_t num_bonds = 5000;
+    vector<Bond> bonds(num_bonds);
+    for (size_t i = 0; i < num_bonds; ++i)
+    {
+        bonds[i].coupon = 0.01 + 0.06 * uniform();
+        bonds[i].frequency = uniform() < 0.5 ? 1 : 2;
+        bonds[i].maturity = 0.5 + 29.5 * uniform();
+        bonds[i].dirty_price = bond_price_z_spread(bonds[i], curve, 0.0005 + 0.03 * uniform());
+    }
+    AssetSwapBatch batch = build_asset_swap_batch(bonds, curve, 4);
+    vector<double> prices(num_bonds);
+    for (size_t i = 0; i < num_bonds; ++i) prices[i] = bonds[i].dirty_price;
+
+    // 3. Par-Par and Market-Value Asset Swap Spreads with Risk
+    AssetSwapResults par_par, market_value;
+    asset_swap_batch_adjoint_mode(batch, curve, prices, AssetSwapType::ParPar, true, par_par);
+    asset_swap_batch_adjoint_mode(batch, curve, prices, AssetSwapType::MarketValue, true, market_value);
+
+    // Check one bond against spreads worked out by hand: flat 4% curve, 2Y 5% annual bond at a 100bp z-spread
+    //   P       = 0.05.exp(-0.05) + 1.05.exp(-0.10)         = 0.997641
+    //   P_curve = 0.05.exp(-0.04) + 1.05.exp(-0.08)         = 1.017312
+    //   A       = 0.25.sum_{i=1..8} exp(-0.04 x 0.25i)      = 1.912497
+    //   par-par spread      = (P_curve - P) / A     = 102.854418bp
+    //   market-value spread = (P_curve - P) / (P.A) = 103.097650bp
+    double max_error = 0.0;
+    {
+        Curve flat = curve;
+        for (double& z : flat.zero_rate) z = 0.04;
+        Bond bond = { 0.05, 1, 2.0, 0.0 };
+        bond.dirty_price = bond_price_z_spread(bond, flat, 0.01);
+        AssetSwapBatch one = build_asset_swap_batch({ bond }, flat, 4);
+        AssetSwapResults pp, mv;
+        asset_swap_batch_adjoint_mode(one, flat, { bond.dirty_price }, AssetSwapType::ParPar, false, pp);
+        asset_swap_batch_adjoint_mode(one, flat, { bond.dirty_price }, AssetSwapType::MarketValue, false, mv);
+        max_error = max(fabs(pp.spread[0] * 1e4 - 102.854418), fabs(mv.spread[0] * 1e4 - 103.097650));
+    }
+
+    cout << std::fixed << std::setprecision(2);
+    cout << "Bonds: " << num_bonds << ", cashflows: " << batch.bond_t.size() << " bond + " << batch.float_t.size() << " float" << endl;
+    cout << "Max spread error vs hand-worked 2Y bond (bp): " << scientific << max_error << fixed << endl << endl;
+
+    for (size_t i = 0; i < 3; ++i)
+    {
+        cout << "Bond " << i << ": coupon " << bonds[i].coupon * 100 << "%, maturity " << bonds[i].maturity
+             << "Y, dirty price " << prices[i] * 100 << endl;
+        cout << "  Par-par spread (bp): " << par_par.spread[i] * 1e4 << ", market-value spread (bp): " << market_value.spread[i] * 1e4 << endl;
+        cout << "  d spread / d price (bp per price point): par-par " << par_par.spread_price[i] * 1e4 * 0.01
+             << ", market-value " << market_value.spread_price[i] * 1e4 * 0.01 << endl;
+        cout << "  Par-par spread change per 1bp pillar shift (bp):";   // 1e-4 shift x 1e4 bp cancel
+        for (size_t k = 0; k < p; ++k) cout << " " << curve.pillar_t[k] << "Y=" << setprecision(4) << par_par.spread_zero[i * p + k] << setprecision(2);
+        cout << endl;
+    }
+
+    // 4. Check the adjoints against central bump & revalue for a sample of bonds
+    const double h = 1e-6;
+    double max_diff = 0.0;
+    for (AssetSwapType type : { AssetSwapType::ParPar, AssetSwapType::MarketValue })
+    {
+        const AssetSwapResults& res = type == AssetSwapType::ParPar ? par_par : market_value;
+        AssetSwapResults up, down;
+        for (size_t k = 0; k < p; ++k)
+        {
+            Curve bumped = curve;
+            bumped.zero_rate[k] += h; asset_swap_batch_adjoint_mode(batch, bumped, prices, type, false, up);
+            bumped.zero_rate[k] -= 2*h; asset_swap_batch_adjoint_mode(batch, bumped, prices, type, false, down);
+            for (size_t i = 0; i < num_bonds; i += 50)
+                max_diff = max(max_diff, fabs((up.spread[i] - down.spread[i]) / (2*h) - res.spread_zero[i * p + k]));
+        }
+        vector<double> bumped = prices;
+        for (double& x : bumped) x += h;
+        asset_swap_batch_adjoint_mode(batch, curve, bumped, type, false, up);
+        for (double& x : bumped) x -= 2*h;
+        asset_swap_batch_adjoint_mode(batch, curve, bumped, type, false, down);
+        for (size_t i = 0; i < num_bonds; i += 50)
+            max_diff = max(max_diff, fabs((up.spread[i] - down.spread[i]) / (2*h) - res.spread_price[i]));
+    }
+    cout << endl << "Max adjoint vs bump & revalue difference: " << scientific << max_diff << fixed << endl;
+
+    // 5. Timing per curve tick for the whole inventory
+    auto now = []() { return chrono::high_resolution_clock::now(); };
+    auto micros = [](chrono::high_resolution_clock::time_point a, chrono::high_resolution_clock::time_point b) {
+        return chrono::duration<double, micro>(b - a).count();
+    };
+    const int repeats = 200;
+    Curve tick = curve;
+    auto t0 = now();
+    for (int r = 0; r < repeats; ++r)
+    {
+        tick.zero_rate[r % p] += (r % 2 == 0 ? 1e-5 : -1e-5);
+        asset_swap_batch_adjoint_mode(batch, tick, prices, AssetSwapType::ParPar, false, par_par);
+    }
+    double spread_us = micros(t0, now()) / repeats;
+    t0 = now();
+    for (int r = 0; r < repeats; ++r)
+    {
+        tick.zero_rate[r % p] += (r % 2 == 0 ? 1e-5 : -1e-5);
+        asset_swap_batch_adjoint_mode(batch, tick, prices, AssetSwapType::ParPar, true, par_par);
+    }
+    double risk_us = micros(t0, now()) / repeats;
+
+    cout << endl << "Per curve tick for " << num_bonds << " bonds:" << endl;
+    cout << "  Spreads only:                " << setw(10) << spread_us << " us" << endl;
+    cout << "  Spreads + price & curve risk:" << setw(10) << risk_us << " us (" << risk_us / spread_us << "x)" << endl;
+    cout << "  Bump & revalue equivalent:   " << setw(10) << spread_us * (2 * p + 2) << " us (central bumps of "
+         << p << " pillars and the price)" << endl;
+
+    return 0;
+}
@@ -0,0 +1,416 @@
+// This file demo's how to cache the yield curve calibration Jacobian and keep it up to date between calibrations
+// using Broyden rank-one updates, so that converting zero rate risk into par rate (market quote) risk is a cheap
+// matrix-vector product on every market tick.
+
+// Curve Jacobian (see RiskJacobian.xlsm)
+// The curve zero rates z are calibrated so that the par rates S(z) of the calibration swaps match the market quotes q.
+// The Jacobian J = dS/dz maps zero rate shifts to par rate shifts, so zero rate risk converts to par rate risk with
+//   dPV/dq = J^-T . dPV/dz
+// We keep H = J^-1 (the factorized, i.e. inverted, Jacobian) so the conversion is a matrix-vector product.
+
+// Between full calibrations the quotes move a little on each tick. We then:
+//   1. re-solve the curve with Newton steps that reuse the cached H instead of rebuilding the Jacobian
+//   2. update H with the Broyden rank-one (Sherman-Morrison) update from the secant pair (dz, dS) of the move:
+//          H = H + (dz - H.dS) . dz^T.H / (dz^T.H.dS)
+//   3. measure the drift, i.e. how badly the cached H predicted the move: |H.dS - dz| / |dz|
+// and only rebuild and refactorize the exact Jacobian when the drift exceeds a threshold.
+
+// Against recalibrating each tick with the exact Jacobian, which rebuilds and inverts it on every Newton step, the
+// cache saves the O(n^3) inversions. It is ~3-4x faster per tick up to 20-40 pillars. On larger curves the rank-one
+// updates no longer keep the drift under a 0.2% threshold, the cache refactorizes on most ticks and the gain falls
+// to ~2x at 60 pillars, see the timing table at the end of the demo.
+
+#include <cmath>     // for math methods e.g. exp()
+#include <vector>    // for vectors
+#include <algorithm> // for upper_bound(), swap()
+#include <chrono>    // for timing
+#include <iostream>  // for input/output to console
+#include <iomanip>   // for input/output precision
+using namespace std;
+
+typedef vector<vector<double>> Matrix;
+
+// Yield Curve
+// -----------
+// Zero rates at pillar times, linearly interpolated with flat extrapolation, df(t) = exp(-z(t).t)
+struct Curve
+{
+    vector<double> pillar_t;    // Pillar times in years, also the calibration swap maturities
+    vector<double> zero_rate;   // Zero rates in decimal
+};
+
+// Locate t on the curve: z(t) = w.zero_rate[k] + (1-w).zero_rate[k+1]
+void curve_weights(const Curve& curve, double t, size_t& k, double& w)
+{
+    const vector<double>& x = curve.pillar_t;
+    if (t <= x.front()) { k = 0; w = 1.0; return; }
+    if (t >= x.back())  { k = x.size() - 2; w = 0.0; return; }
+    k = (upper_bound(x.begin(), x.end(), t) - x.begin()) - 1;
+    w = (x[k+1] - t) / (x[k+1] - x[k]);
+}
+
+double curve_df(const Curve& curve, double t)
+{
+    size_t k; double w;
+    curve_weights(curve, t, k, w);
+    return exp(-(w * curve.zero_rate[k] + (1.0 - w) * curve.zero_rate[k+1]) * t);
+}
+
+// Adjoint of curve_df(): add the discount factor risk df_bar to the pillar zero rate risks
+void curve_df_adjoint(const Curve& curve, double t, double df, double df_bar, vector<double>& zero_rate_bar)
+{
+    size_t k; double w;
+    curve_weights(curve, t, k, w);
+    double z_bar = -t * df * df_bar;
+    zero_rate_bar[k] += w * z_bar;
+    zero_rate_bar[k+1] += (1.0 - w) * z_bar;
+}
+
+// Calibration Swaps
+// -----------------
+// Single curve par swap rate with annual fixed coupons: S = (1 - df(T)) / sum df(t_i)
+double par_rate(const Curve& curve, double maturity)
+{
+    double annuity = 0.0;
+    for (double t = 1.0; t <= maturity + 1e-9; t += 1.0) annuity += curve_df(curve, t);
+    return (1.0 - curve_df(curve, maturity)) / annuity;
+}
+
+// Par rate and its zero rate risk dS/dz (one row of the Jacobian) using adjoint mode
+double par_rate_adjoint(const Curve& curve, double maturity, vector<double>& zero_rate_bar)
+{
+    // Forward Sweep
+    vector<double> df;
+    double annuity = 0.0;
+    for (double t = 1.0; t <= maturity + 1e-9; t += 1.0) { df.push_back(curve_df(curve, t)); annuity += df.back(); }
+    double df_T = df.back();
+    double s = (1.0 - df_T) / annuity;
+
+    // Back Propagation, s_bar = 1
+    zero_rate_bar.assign(curve.pillar_t.size(), 0.0);
+    double annuity_bar = -s / annuity;
+    double df_T_bar = -1.0 / annuity;
+    for (size_t i = df.size(); i-- > 0;)
+    {
+        double df_bar = annuity_bar + (i + 1 == df.size() ? df_T_bar : 0.0);
+        curve_df_adjoint(curve, i + 1.0, df[i], df_bar, zero_rate_bar);
+    }
+    return s;
+}
+
+vector<double> par_rates(const Curve& curve)
+{
+    vector<double> s(curve.pillar_t.size());
+    for (size_t k = 0; k < s.size(); ++k) s[k] = par_rate(curve, curve.pillar_t[k]);
+    return s;
+}
+
+// Exact Jacobian J[k][j] = dS_k/dz_j, one adjoint sweep per calibration swap
+Matrix curve_jacobian(const Curve& curve)
+{
+    Matrix jacobian(curve.pillar_t.size());
+    for (size_t k = 0; k < jacobian.size(); ++k) par_rate_adjoint(curve, curve.pillar_t[k], jacobian[k]);
+    return jacobian;
+}
+
+// Invert a matrix using Gauss-Jordan elimination with partial pivoting
+// result is only overwritten on success, a singular matrix leaves it unchanged
+bool invert_matrix(Matrix a, Matrix& result)
+{
+    const size_t n = a.size();
+    Matrix inverse(n, vector<double>(n, 0.0));
+    for (size_t i = 0; i < n; ++i) inverse[i][i] = 1.0;
+    for (size_t c = 0; c < n; ++c)
+    {
+        size_t pivot = c;
+        for (size_t r = c + 1; r < n; ++r) if (fabs(a[r][c]) > fabs(a[pivot][c])) pivot = r;
+        if (fabs(a[pivot][c]) < 1e-14) { cout << "Jacobian Error: Matrix is singular" << endl; return false; }
+        swap(a[c], a[pivot]);
+        swap(inverse[c], inverse[pivot]);
+        double scale = 1.0 / a[c][c];
+        for (size_t j = 0; j < n; ++j) { a[c][j] *= scale; inverse[c][j] *= scale; }
+        for (size_t r = 0; r < n; ++r)
+        {
+            if (r == c || a[r][c] == 0.0) continue;
+            double factor = a[r][c];
+            for (size_t j = 0; j < n; ++j) { a[r][j] -= factor * a[c][j]; inverse[r][j] -= factor * inverse[c][j]; }
+        }
+    }
+    result.swap(inverse);
+    return true;
+}
+
+vector<double> multiply(const Matrix& m, const vector<double>& x)
+{
+    vector<double> y(m.size(), 0.0);
+    for (size_t i = 0; i < m.size(); ++i)
+        for (size_t j = 0; j < x.size(); ++j) y[i] += m[i][j] * x[j];
+    return y;
+}
+
+double norm(const vector<double>& x)
+{
+    double sum = 0.0;
+    for (double v : x) sum += v * v;
+    return sqrt(sum);
+}
+
+// Jacobian Cache
+// --------------
+class JacobianCache
+{
+public:
+    JacobianCache(double drift_threshold, double tolerance) : drift_threshold_(drift_threshold), tolerance_(tolerance) {}
+
+    // Full calibration: Newton-Raphson with the exact Jacobian, then cache the inverse Jacobian at the solution
+    void calibrate(Curve& curve, const vector<double>& quotes)
+    {
+        for (int iteration = 0; iteration < 20; ++iteration)
+        {
+            vector<double> residual = par_rates(curve);
+            for (size_t k = 0; k < residual.size(); ++k) residual[k] = quotes[k] - residual[k];
+            if (norm(residual) < tolerance_) break;
+            Matrix inverse;
+            if (!invert_matrix(curve_jacobian(curve), inverse)) return;
+            vector<double> dz = multiply(inverse, residual);
+            for (size_t k = 0; k < dz.size(); ++k) curve.zero_rate[k] += dz[k];
+        }
+        refactorize(curve);
+    }
+
+    // Market tick: Newton steps reusing the cached inverse Jacobian, with a Broyden update after each step
+    // Returns the number of Newton steps taken
+    int update(Curve& curve, const vector<double>& quotes)
+    {
+        if (inverse_.empty()) { cout << "Jacobian Error: No cached Jacobian, calibrate first" << endl; return 0; }
+        vector<double> s = par_rates(curve);
+        int steps = 0;
+        for (; steps < 10; ++steps)
+        {
+            vector<double> residual(s.size());
+            for (size_t k = 0; k < s.size(); ++k) residual[k] = quotes[k] - s[k];
+            if (norm(residual) < tolerance_) break;
+
+            // Newton step with the cached inverse
+            vector<double> dz = multiply(inverse_, residual);
+            for (size_t k = 0; k < dz.size(); ++k) curve.zero_rate[k] += dz[k];
+            vector<double> s_new = par_rates(curve);
+            vector<double> ds(s.size());
+            for (size_t k = 0; k < s.size(); ++k) ds[k] = s_new[k] - s[k];
+            s = s_new;
+
+            // Tiny final steps are dominated by rounding error in dS and would corrupt H, so skip their update
+            if (norm(dz) < min_update_) continue;
+
+            // Drift: how far the cached inverse was from the true secant dz = H.dS
+            vector<double> h_ds = multiply(inverse_, ds);
+            vector<double> error(dz.size());
+            for (size_t k = 0; k < dz.size(); ++k) error[k] = dz[k] - h_ds[k];
+            drift_ = max(drift_, norm(error) / max(norm(dz), 1e-300));
+
+            // Broyden rank-one update: H = H + (dz - H.dS) . (dz^T.H) / (dz^T.H.dS)
+            double denominator = 0.0;
+            for (size_t k = 0; k < dz.size(); ++k) denominator += dz[k] * h_ds[k];
+            if (fabs(denominator) < 1e-300) continue;
+            vector<double> dz_h(dz.size(), 0.0);
+            for (size_t i = 0; i < dz.size(); ++i)
+                for (size_t j = 0; j < dz.size(); ++j) dz_h[j] += dz[i] * inverse_[i][j];
+            for (size_t i = 0; i < dz.size(); ++i)
+                for (size_t j = 0; j < dz.size(); ++j) inverse_[i][j] += error[i] * dz_h[j] / denominator;
+            ++broyden_updates_;
+        }
+
+        if (drift_ > drift_threshold_) refactorize(curve);
+        return steps;
+    }
+
+    // Convert zero rate risk dPV/dz into par rate risk dPV/dq = H^T.dPV/dz, a matrix-vector product
+    // zero_risk must be computed on the current curve, risk from before a market move gives stale par risk
+    vector<double> par_risk(const vector<double>& zero_risk) const
+    {
+        vector<double> risk(zero_risk.size(), 0.0);
+        for (size_t j = 0; j < zero_risk.size(); ++j)
+            for (size_t k = 0; k < zero_risk.size(); ++k) risk[k] += zero_risk[j] * inverse_[j][k];
+        return risk;
+    }
+
+    const Matrix& inverse_jacobian() const { return inverse_; }
+    size_t refactorizations() const { return refactorizations_; }
+    size_t broyden_updates() const { return broyden_updates_; }
+
+private:
+    // Rebuild the exact Jacobian at the current curve and cache its inverse
+    // If the Jacobian is singular keep the old inverse and its drift, so the next tick tries again
+    void refactorize(const Curve& curve)
+    {
+        if (!invert_matrix(curve_jacobian(curve), inverse_)) return;
+        drift_ = 0.0;
+        ++refactorizations_;
+    }
+
+    double drift_threshold_;        // Refactorize when the drift exceeds this
+    double tolerance_;              // Calibration tolerance on the par rate residuals
+    const double min_update_ = 1e-8;// Smallest zero rate step used for a Broyden update, 0.0001bp
+    double drift_ = 0.0;            // Largest relative secant error since the last refactorization
+    Matrix inverse_;                // Cached inverse Jacobian H = dz/dq
+    size_t refactorizations_ = 0;
+    size_t broyden_updates_ = 0;
+};
+
+// Book zero rate risk: PV change for a 1bp shift of each curve zero rate, for a book of annual fixed receiver swaps
+vector<double> book_zero_risk(const Curve& curve, const vector<double>& maturities, const vector<double>& notionals, const vector<double>& fixed_rates)
+{
+    vector<double> zero_risk(curve.pillar_t.size(), 0.0);
+    for (size_t n = 0; n < maturities.size(); ++n)
+    {
+        // Receiver swap PV = N.(r.sum df(t_i) - (1 - df(T))), adjoint: df_bar = N.r (+ N at maturity)
+        for (double t = 1.0; t <= maturities[n] + 1e-9; t += 1.0)
+        {
+            double df_bar = notionals[n] * fixed_rates[n] + (t + 1.0 > maturities[n] + 1e-9 ? notionals[n] : 0.0);
+            curve_df_adjoint(curve, t, curve_df(curve, t), df_bar * 0.0001, zero_risk);
+        }
+    }
+    return zero_risk;
+}
+
+// Time a curve tick with the cached Jacobian against an exact recalibration of the same tick, for a curve with
+// annual pillars 1Y .. num_pillars Y. Returns the average time per tick of each in microseconds, and the number of
+// refactorizations the drift check forced on the cached curve.
+void time_curve_size(size_t num_pillars, int ticks, double& cached_us, double& exact_us, size_t& refactorizations)
+{
+    Curve curve;
+    vector<double> quotes;
+    for (size_t k = 0; k < num_pillars; ++k)
+    {
+        curve.pillar_t.push_back(k + 1.0);
+        quotes.push_back(0.030 + 0.006 * (1.0 - exp(-(k + 1.0) / 5.0)));
+    }
+    curve.zero_rate.assign(num_pillars, 0.03);
+
+    JacobianCache cache(0.002, 1e-10);
+    cache.calibrate(curve, quotes);
+    unsigned int seed = 54321;
+    auto uniform = [&seed]() { seed = seed * 1664525u + 1013904223u; return (seed >> 8) / 16777216.0; };
+    cached_us = exact_us = 0.0;
+    for (int tick = 0; tick < ticks; ++tick)
+    {
+        for (double& q : quotes) q += 0.00005 * (uniform() - 0.5);
+        Curve exact_curve = curve;
+        JacobianCache exact(0.0, 1e-10);
+
+        auto t0 = chrono::steady_clock::now();
+        cache.update(curve, quotes);
+        auto t1 = chrono::steady_clock::now();
+        exact.calibrate(exact_curve, quotes);
+        auto t2 = chrono::steady_clock::now();
+        cached_us += chrono::duration<double, micro>(t1 - t0).count();
+        exact_us += chrono::duration<double, micro>(t2 - t1).count();
+    }
+    cached_us /= ticks;
+    exact_us /= ticks;
+    refactorizations = cache.refactorizations() - 1;     // the first one is the full calibration
+}
+
+void display(const string& name, const Curve& curve, const vector<double>& risk)
+{
+    cout << name << ":" << std::fixed;
+    for (size_t k = 0; k < risk.size(); ++k) cout << " " << std::setprecision(0) << curve.pillar_t[k] << "Y=" << std::setprecision(2) << risk[k];
+    cout << endl;
+}
+
+int main()
+{
+    // 1. Market Quotes: par swap rates for the calibration swaps
+    Curve curve;
+    curve.pillar_t = { 1.0, 2.0, 3.0, 4.0, 5.0, 7.0, 10.0, 15.0, 20.0, 30.0 };
+    curve.zero_rate.assign(curve.pillar_t.size(), 0.03);
+    vector<double> quotes = { 0.0300, 0.0310, 0.0318, 0.0325, 0.0330, 0.0338, 0.0345, 0.0350, 0.0350, 0.0345 };
+
+    // 2. Book: receiver swaps across the curve
+    vector<double> maturities, notionals, fixed_rates;
+    unsigned int seed = 12345;
+    auto uniform = [&seed]() { seed = seed * 1664525u + 1013904223u; return (seed >> 8) / 16777216.0; };
+    for (int n = 0; n < 1000; ++n)
+    {
+        maturities.push_back(1 + (int)(uniform() * 30));
+        notionals.push_back((uniform() < 0.5 ? -1.0 : 1.0) * 1000000.0 * (1 + (int)(uniform() * 50)));
+        fixed_rates.push_back(0.025 + 0.015 * uniform());
+    }
+
+    // 3. Full Calibration and Jacobian Cache
+    JacobianCache cache(0.002, 1e-10);
+    cache.calibrate(curve, quotes);
+    vector<double> zero_risk = book_zero_risk(curve, maturities, notionals, fixed_rates);
+
+    cout << "Full Calibration" << endl;
+    display("Zero Rate DV01", curve, zero_risk);
+    display("Par Rate DV01 ", curve, cache.par_risk(zero_risk));
+    cout << endl;
+
+    // 4. Market Ticks: small random quote moves, with one large move half way through
+    //    The book zero rate risk is recomputed on every tick, so the par risk is never converted from stale risk
+    const int ticks = 10000;
+    int newton_steps = 0;
+    double max_error = 0.0;
+    double tick_us = 0.0, risk_us = 0.0, full_us = 0.0;
+    for (int tick = 0; tick < ticks; ++tick)
+    {
+        for (double& q : quotes) q += 0.00005 * (uniform() - 0.5);                // +/- 0.25bp moves
+        if (tick == ticks / 2)                                                      // market jump: 25bp steepener
+            for (size_t k = 0; k < quotes.size(); ++k) quotes[k] += 0.0025 * curve.pillar_t[k] / 30.0;
+        Curve exact_curve = curve;
+
+        auto t0 = chrono::steady_clock::now();
+        newton_steps += cache.update(curve, quotes);
+        auto t1 = chrono::steady_clock::now();
+        zero_risk = book_zero_risk(curve, maturities, notionals, fixed_rates);
+        auto t2 = chrono::steady_clock::now();
+        vector<double> par_risk = cache.par_risk(zero_risk);
+        auto t3 = chrono::steady_clock::now();
+        tick_us += chrono::duration<double, micro>(t1 - t0).count();
+        risk_us += chrono::duration<double, micro>(t3 - t2).count();
+
+        // Compare against recalibrating the same tick with the exact Jacobian every 100 ticks
+        if (tick % 100 == 0)
+        {
+            JacobianCache exact(0.0, 1e-10);
+            auto t4 = chrono::steady_clock::now();
+            exact.calibrate(exact_curve, quotes);
+            auto t5 = chrono::steady_clock::now();
+            full_us += chrono::duration<double, micro>(t5 - t4).count();
+            vector<double> exact_risk = exact.par_risk(book_zero_risk(exact_curve, maturities, notionals, fixed_rates));
+            vector<double> difference(par_risk.size());
+            for (size_t k = 0; k < par_risk.size(); ++k) difference[k] = par_risk[k] - exact_risk[k];
+            max_error = max(max_error, norm(difference) / norm(exact_risk));
+        }
+    }
+
+    vector<double> s = par_rates(curve);
+    double max_residual = 0.0;
+    for (size_t k = 0; k < s.size(); ++k) max_residual = max(max_residual, fabs(s[k] - quotes[k]));
+
+    cout << "Market Ticks: " << ticks << endl;
+    cout << "Newton steps per tick: " << std::fixed << std::setprecision(2) << (double)newton_steps / ticks << endl;
+    cout << "Broyden updates: " << cache.broyden_updates() << ", full refactorizations: " << cache.refactorizations() << endl;
+    cout << "Max calibration residual: " << std::scientific << std::setprecision(2) << max_residual << endl;
+    cout << "Max par risk error vs exact Jacobian |error|/|risk|: " << std::scientific << std::setprecision(2) << max_error << endl;
+    cout << "Time per tick, curve update with cached Jacobian: " << std::fixed << std::setprecision(2) << tick_us / ticks << " us" << endl;
+    cout << "Time per tick, exact recalibration with Jacobian rebuild + refactorization: " << std::fixed << std::setprecision(2) << full_us / (ticks / 100) << " us" << endl;
+    cout << "Time per tick, book par risk conversion: " << std::fixed << std::setprecision(3) << risk_us / ticks << " us" << endl;
+    cout << endl;
+    display("Par Rate DV01 ", curve, cache.par_risk(zero_risk));
+
+    // 5. Curve Size: the cached update costs O(n^2) per Newton step, an exact recalibration O(n^3) per step
+    const int size_ticks = 200;
+    cout << endl << "Pillars   Cached tick (us)   Exact tick (us)   Speed-up   Refactorizations per " << size_ticks << " ticks" << endl;
+    for (size_t num_pillars : { 5, 10, 20, 40, 60 })
+    {
+        double cached_us, exact_us;
+        size_t refactorizations;
+        time_curve_size(num_pillars, size_ticks, cached_us, exact_us, refactorizations);
+        cout << setw(7) << num_pillars << setw(19) << cached_us << setw(18) << exact_us << setw(10) << exact_us / cached_us << "x"
+             << setw(19) << refactorizations << endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,357 @@
+// This file demo's how to price a strip of 3M SOFR futures with a Hull-White convexity adjustment, with adjoint risk
+// We compute the 3M SOFR settlement from daily fixings, price all contracts in one call and calibrate a curve to them.
+
+// 3M SOFR futures settle on the daily compounded SOFR over the reference quarter [T1, T2]:
+//   R = (prod_i (1 + r_i.d_i/360) - 1) . 360/D,    price = 100.(1 - R)
+// where d_i is the number of calendar days fixing r_i applies for (3 over a weekend) and D the days in the quarter.
+// Before and during the reference quarter, the fixings already published compound into a known factor K and the
+// rest is projected from the curve, the compounded overnight rate over [t, T2] being df(t)/df(T2) - 1.
+
+// Futures are margined daily so the futures rate is the risk neutral expectation of R, which is above the forward
+// rate. In Hull-White, dr = (theta(t) - a.r)dt + sigma.dW, the compounded factor is lognormal and
+//   E[1 + tau.R] = K . df(T1)/df(T2) . exp(Gamma),    Gamma = sigma^2 . g(a, T1, T2)
+//   g = B12^2 (1 - e^{-2a.T1})/(2a) + B12 B01^2 / 2 + (tau - 2 B(tau) + B2(tau)) / a^2
+// with B(x) = (1 - e^{-a.x})/a, B12 = B(T2 - T1), B01 = B(T1), B2(x) = (1 - e^{-2a.x})/(2a), T1 floored at today.
+// The last term is the variance of the rate accrued inside the reference quarter. Eurodollar (LIBOR) futures fix
+// at T1 so they omit it, which gives the familiar Hull formula for the Eurodollar convexity adjustment.
+
+// g only depends on the contract dates and the mean reversion, so it is cached with the strip. A curve tick then
+// prices all 40 contracts in one flat loop, and the adjoint sweep in the same loop gives every contract's
+// sensitivity to all curve pillars and to sigma. This is the Jacobian a Newton curve calibration needs every tick.
+
+#include <cmath>         // for math methods e.g. exp()
+#include <vector>        // for vectors
+#include <algorithm>     // for upper_bound()
+#include <chrono>        // for timing
+#include <iostream>      // for input/output to console
+#include <iomanip>       // for input/output precision
+using namespace std;
+
+// Dates are days from today, day 0 is a Monday
+bool is_business_day(int day) { int wd = ((day % 7) + 7) % 7; return wd < 5; }
+
+// Daily Compounded SOFR
+// ---------------------
+// Compounded factor prod (1 + r_i.d_i/360) over the business days in [from, to)
+// If from is not a business day, the days up to the next business day accrue at the previous business day's fixing
+// fixings[day + history_days] is the SOFR published for that business day
+double sofr_compounded_factor(const vector<double>& fixings, int history_days, int from, int to)
+{
+    double factor = 1.0;
+    int fixing_day = from;
+    while (!is_business_day(fixing_day)) --fixing_day;
+    for (int day = from; day < to; )
+    {
+        int next = day + 1;
+        while (next < to && !is_business_day(next)) ++next;     // the rate applies until the next business day
+        factor *= 1.0 + fixings[fixing_day + history_days] * (next - day) / 360.0;
+        day = fixing_day = next;
+    }
+    return factor;
+}
+
+// Final settlement price of a 3M SOFR future whose reference quarter has fully fixed
+double sofr_settlement_price(const vector<double>& fixings, int history_days, int start_day, int end_day)
+{
+    double rate = (sofr_compounded_factor(fixings, history_days, start_day, end_day) - 1.0) * 360.0 / (end_day - start_day);
+    return 100.0 * (1.0 - rate);
+}
+
+// Yield Curve
+// -----------
+// Zero rates at pillar times, linearly interpolated with flat extrapolation, df(t) = exp(-z(t).t)
+struct Curve
+{
+    vector<double> pillar_t;    // Pillar times in years
+    vector<double> zero_rate;   // Zero rates in decimal
+};
+
+// Locate t on the curve: z(t) = w.zero_rate[k] + (1-w).zero_rate[k+1]
+void curve_weights(const Curve& curve, double t, size_t& k, double& w)
+{
+    const vector<double>& x = curve.pillar_t;
+    if (t <= x.front()) { k = 0; w = 1.0; return; }
+    if (t >= x.back())  { k = x.size() - 2; w = 0.0; return; }
+    k = (upper_bound(x.begin(), x.end(), t) - x.begin()) - 1;
+    w = (x[k+1] - t) / (x[k+1] - x[k]);
+}
+
+// Futures Strip
+// -------------
+enum class FuturesType { SOFR3M, Eurodollar };
+
+// Contract data in structure-of-arrays, built once per strip and mean reversion
+struct FuturesStrip
+{
+    size_t size = 0;
+    vector<double> t1;          // Projection start: max(T1, today) in years
+    vector<double> t2;          // Reference quarter end T2 in years
+    vector<double> tau;         // Reference quarter D/360
+    vector<double> known;       // Known compounded factor K from published fixings
+    vector<double> g;           // Hull-White convexity factor, Gamma = sigma^2.g
+    vector<int> k1, k2;         // Cached curve buckets of t1 and t2
+    vector<double> w1, w2;      // Cached curve weights of t1 and t2
+};
+
+// Hull-White convexity factor g(a, T1, T2), see the top of the file
+double hull_white_convexity(FuturesType type, double a, double T1, double T2)
+{
+    auto B = [a](double x) { return (1.0 - exp(-a * x)) / a; };
+    double tau = T2 - T1, B12 = B(tau), B01 = B(T1);
+    double g = B12 * B12 * (1.0 - exp(-2.0 * a * T1)) / (2.0 * a) + B12 * B01 * B01 / 2.0;
+    if (type == FuturesType::SOFR3M) g += (tau - 2.0 * B(tau) + (1.0 - exp(-2.0 * a * tau)) / (2.0 * a)) / (a * a);
+    return g;
+}
+
+FuturesStrip build_futures_strip( FuturesType type,                 // [IN]: SOFR 3M or Eurodollar
+                                  const vector<int>& start_day,     // [IN]: Reference quarter start dates
+                                  const vector<int>& end_day,       // [IN]: Reference quarter end dates
+                                  const vector<double>& fixings,    // [IN]: Published SOFR fixings
+                                  int history_days,                 // [IN]: Days of fixing history
+                                  double mean_reversion,            // [IN]: Hull-White mean reversion a
+                                  const Curve& curve                // [IN]: Curve pillars
+                                )
+{
+    FuturesStrip strip;
+    strip.size = start_day.size();
+    for (size_t i = 0; i < strip.size; ++i)
+    {
+        int from = max(start_day[i], 0);
+        double t1 = from / 365.0, t2 = end_day[i] / 365.0;
+        strip.t1.push_back(t1);
+        strip.t2.push_back(t2);
+        strip.tau.push_back((end_day[i] - start_day[i]) / 360.0);
+        strip.known.push_back(type == FuturesType::SOFR3M && start_day[i] < 0 ? sofr_compounded_factor(fixings, history_days, start_day[i], 0) : 1.0);
+        strip.g.push_back(hull_white_convexity(type, mean_reversion, t1, t2));
+        size_t k; double w;
+        curve_weights(curve, t1, k, w); strip.k1.push_back((int)k); strip.w1.push_back(w);
+        curve_weights(curve, t2, k, w); strip.k2.push_back((int)k); strip.w2.push_back(w);
+    }
+    return strip;
+}
+
+// Price the strip and compute every contract's sensitivity to the curve pillars and sigma using adjoint mode
+void futures_strip_adjoint_mode( const FuturesStrip& strip,         // [IN]: Futures strip
+                                 const Curve& curve,                // [IN]: SOFR curve
+                                 double sigma,                      // [IN]: Hull-White normal volatility
+                                 vector<double>& price,             // [OUT]: Futures prices
+                                 vector<double>& convexity,         // [OUT]: Convexity adjustment, futures - forward rate
+                                 vector<double>& price_zero,        // [OUT]: d price / d zero rate, [contract * pillars + pillar]
+                                 vector<double>& price_sigma        // [OUT]: d price / d sigma
+                               )
+{
+    const size_t n = strip.size, p = curve.pillar_t.size();
+    const double* z = curve.zero_rate.data();
+    price.resize(n); convexity.resize(n); price_sigma.resize(n);
+    price_zero.assign(n * p, 0.0);
+
+    for (size_t i = 0; i < n; ++i)
+    {
+        // Forward Sweep for Price
+        // -----------------------
+
+        // STEP 1: Discount factors at the projection start and the quarter end
+        double z1 = strip.w1[i] * z[strip.k1[i]] + (1.0 - strip.w1[i]) * z[strip.k1[i] + 1];
+        double z2 = strip.w2[i] * z[strip.k2[i]] + (1.0 - strip.w2[i]) * z[strip.k2[i] + 1];
+        double df1 = exp(-z1 * strip.t1[i]), df2 = exp(-z2 * strip.t2[i]);
+
+        // STEP 2: Convexity adjusted compounded factor, E[1 + tau.R] = K.df1/df2.exp(Gamma)
+        double gamma = sigma * sigma * strip.g[i];
+        double forward_factor = strip.known[i] * df1 / df2;
+        double futures_factor = forward_factor * exp(gamma);
+
+        // STEP 3: Futures rate and price
+        double rate = (futures_factor - 1.0) / strip.tau[i];
+        price[i] = 100.0 * (1.0 - rate);
+        convexity[i] = (futures_factor - forward_factor) / strip.tau[i];
+
+        // Back Propagation for Risk
+        // -------------------------
+
+        // STEP 3: Futures price, seed price_bar = 1
+        double rate_bar = -100.0;
+        double futures_factor_bar = rate_bar / strip.tau[i];
+
+        // STEP 2: Convexity adjusted compounded factor
+        double gamma_bar = futures_factor_bar * futures_factor;
+        double df1_bar = futures_factor_bar * futures_factor / df1;
+        double df2_bar = -futures_factor_bar * futures_factor / df2;
+        price_sigma[i] = gamma_bar * 2.0 * sigma * strip.g[i];
+
+        // STEP 1: Discount factors to pillar zero rates, df = exp(-z.t), z = w.z[k] + (1-w).z[k+1]
+        double* zero_bar = &price_zero[i * p];
+        double z1_bar = -strip.t1[i] * df1 * df1_bar, z2_bar = -strip.t2[i] * df2 * df2_bar;
+        zero_bar[strip.k1[i]] += strip.w1[i] * z1_bar;
+        zero_bar[strip.k1[i] + 1] += (1.0 - strip.w1[i]) * z1_bar;
+        zero_bar[strip.k2[i]] += strip.w2[i] * z2_bar;
+        zero_bar[strip.k2[i] + 1] += (1.0 - strip.w2[i]) * z2_bar;
+    }
+}
+
+// Solve A.x = b by Gaussian elimination with partial pivoting, A is n x n row major and is overwritten
+bool solve_linear(vector<double>& A, vector<double>& b, size_t n)
+{
+    for (size_t c = 0; c < n; ++c)
+    {
+        size_t pivot = c;
+        for (size_t r = c + 1; r < n; ++r) if (fabs(A[r*n + c]) > fabs(A[pivot*n + c])) pivot = r;
+        if (fabs(A[pivot*n + c]) < 1e-14) return false;
+        if (pivot != c) { for (size_t j = 0; j < n; ++j) swap(A[c*n + j], A[pivot*n + j]); swap(b[c], b[pivot]); }
+        for (size_t r = c + 1; r < n; ++r)
+        {
+            double f = A[r*n + c] / A[c*n + c];
+            if (f == 0.0) continue;
+            for (size_t j = c; j < n; ++j) A[r*n + j] -= f * A[c*n + j];
+            b[r] -= f * b[c];
+        }
+    }
+    for (size_t c = n; c-- > 0; )
+    {
+        for (size_t j = c + 1; j < n; ++j) b[c] -= A[c*n + j] * b[j];
+        b[c] /= A[c*n + c];
+    }
+    return true;
+}
+
+// Calibrate the curve zero rates so the strip reprices the market futures prices, one pillar per contract end
+int calibrate_curve_to_strip(const FuturesStrip& strip, double sigma, const vector<double>& market, Curve& curve, double tolerance)
+{
+    const size_t n = strip.size;
+    if (market.size() != n)                 { cout << "Calibration Error: Wrong number of market prices" << endl; return -1; }
+    if (curve.pillar_t.size() != n)         { cout << "Calibration Error: The curve needs one pillar per contract" << endl; return -1; }
+    for (size_t i = 0; i < n; ++i)
+    {
+        if (fabs(curve.pillar_t[i] - strip.t2[i]) > 1e-12) { cout << "Calibration Error: Curve pillar " << i << " is not on its contract end" << endl; return -1; }
+    }
+
+    vector<double> price, convexity, jacobian, vega;
+    for (int iter = 1; iter <= 20; ++iter)
+    {
+        futures_strip_adjoint_mode(strip, curve, sigma, price, convexity, jacobian, vega);
+        vector<double> residual(n);
+        double max_residual = 0.0;
+        for (size_t i = 0; i < n; ++i) { residual[i] = market[i] - price[i]; max_residual = max(max_residual, fabs(residual[i])); }
+        if (max_residual < tolerance) return iter - 1;
+        if (!solve_linear(jacobian, residual, n)) { cout << "Calibration Error: singular futures Jacobian" << endl; return -1; }
+        for (size_t k = 0; k < n; ++k) curve.zero_rate[k] += residual[k];
+    }
+    cout << "Calibration Error: no convergence" << endl;
+    return -1;
+}
+
+// Simple random number generator, uniform on [0,1)
+unsigned int seed = 12345;
+double uniform()
+{
+    seed = seed * 1664525u + 1013904223u;
+    return (seed >> 8) / 16777216.0;
+}
+
+int main()
+{
+    // 1. SOFR Fixing History: last 200 days, weekend entries are not used
+    const int history_days = 200;
+    vector<double> fixings(history_days);
+    double sofr = 0.0440;
+    for (int day = -history_days; day < 0; ++day)
+    {
+        if (is_business_day(day)) sofr += 0.0002 * (uniform() - 0.55);
+        fixings[day + history_days] = sofr;
+    }
+
+    // 2. 3M SOFR Settlement from Daily Fixings: a contract whose reference quarter ended last week
+    int settled_start = -96, settled_end = -5;      // Wednesday to Wednesday
+    cout << std::fixed << std::setprecision(4);
+    cout << "Settled contract, reference quarter " << settled_end - settled_start << " days, final settlement price: "
+         << sofr_settlement_price(fixings, history_days, settled_start, settled_end) << endl;
+
+    // Accrual starting on a Saturday: the weekend accrues at Friday's fixing, then Monday and Tuesday for a day each
+    double weekend_factor = (1.0 + fixings[-10 + history_days] * 2.0 / 360.0) * (1.0 + fixings[-7 + history_days] / 360.0)
+                          * (1.0 + fixings[-6 + history_days] / 360.0);
+    cout << "Compounding from a Saturday vs by hand, difference: " << scientific << setprecision(2)
+         << fabs(sofr_compounded_factor(fixings, history_days, -9, -5) - weekend_factor) << fixed << setprecision(4) << endl;
+
+    // 3. Strip: 40 quarterly contracts, the front contract is inside its reference quarter
+    const size_t n = 40;
+    vector<int> start_day(n), end_day(n);
+    for (size_t i = 0; i < n; ++i) { start_day[i] = -5 + 91 * (int)i; end_day[i] = start_day[i] + 91; }
+
+    // 4. Market: the curve has one pillar per contract end, Hull-White a = 3%, sigma = 1%
+    Curve curve;
+    for (size_t i = 0; i < n; ++i)
+    {
+        curve.pillar_t.push_back(end_day[i] / 365.0);
+        curve.zero_rate.push_back(0.0430 - 0.0060 * (1.0 - exp(-curve.pillar_t[i] / 2.0)) + 0.0010 * curve.pillar_t[i] / 10.0);
+    }
+    const double a = 0.03, sigma = 0.01;
+    FuturesStrip strip = build_futures_strip(FuturesType::SOFR3M, start_day, end_day, fixings, history_days, a, curve);
+    FuturesStrip ed_strip = build_futures_strip(FuturesType::Eurodollar, start_day, end_day, fixings, history_days, a, curve);
+
+    vector<double> price, convexity, price_zero, price_sigma;
+    futures_strip_adjoint_mode(strip, curve, sigma, price, convexity, price_zero, price_sigma);
+    vector<double> ed_price, ed_convexity, ed_zero, ed_sigma;
+    futures_strip_adjoint_mode(ed_strip, curve, sigma, ed_price, ed_convexity, ed_zero, ed_sigma);
+
+    const size_t p = n;
+    cout << endl << "Contract   T2 (y)      Price   Convexity (bp)   ED-style convexity (bp)   DV01 (T1, T2)      Vega (1bp sigma)" << endl;
+    for (size_t i : { 0, 1, 4, 8, 20, 39 })
+    {
+        double dv01_1 = 0.0, dv01_2 = price_zero[i * p + i] * 1e-4;
+        if (i > 0) dv01_1 = price_zero[i * p + i - 1] * 1e-4;
+        cout << setw(8) << i + 1 << setw(9) << setprecision(2) << curve.pillar_t[i] << setw(11) << setprecision(4) << price[i]
+             << setw(17) << convexity[i] * 1e4 << setw(26) << ed_convexity[i] * 1e4
+             << setw(10) << dv01_1 << setw(9) << dv01_2 << setw(19) << price_sigma[i] * 1e-4 << endl;
+    }
+
+    // 5. Check the adjoints against central bump & revalue
+    const double h = 1e-7;
+    double max_diff = 0.0;
+    vector<double> up, down, c, j, s;
+    for (size_t k = 0; k < p; ++k)
+    {
+        Curve bumped = curve;
+        bumped.zero_rate[k] += h; futures_strip_adjoint_mode(strip, bumped, sigma, up, c, j, s);
+        bumped.zero_rate[k] -= 2*h; futures_strip_adjoint_mode(strip, bumped, sigma, down, c, j, s);
+        for (size_t i = 0; i < n; ++i) max_diff = max(max_diff, fabs((up[i] - down[i]) / (2*h) - price_zero[i * p + k]));
+    }
+    futures_strip_adjoint_mode(strip, curve, sigma + h, up, c, j, s);
+    futures_strip_adjoint_mode(strip, curve, sigma - h, down, c, j, s);
+    for (size_t i = 0; i < n; ++i) max_diff = max(max_diff, fabs((up[i] - down[i]) / (2*h) - price_sigma[i]));
+    cout << endl << "Max adjoint vs bump & revalue difference: " << scientific << setprecision(2) << max_diff << fixed << endl;
+
+    // 6. Curve Calibration to the Strip: market prices from the curve above, start from a flat curve
+    vector<double> market = price;
+    Curve calibrated = curve;
+    for (double& zr : calibrated.zero_rate) zr = 0.04;
+    int iterations = calibrate_curve_to_strip(strip, sigma, market, calibrated, 1e-10);
+    double max_zero_error = 0.0;
+    for (size_t k = 0; k < p; ++k) max_zero_error = max(max_zero_error, fabs(calibrated.zero_rate[k] - curve.zero_rate[k]));
+    cout << "Calibration from a flat curve: " << iterations << " Newton iterations, max zero rate error "
+         << scientific << max_zero_error << fixed << endl;
+
+    // 7. Timing: strip pricing with full risk, and recalibration after a market tick
+    auto now = []() { return chrono::high_resolution_clock::now(); };
+    auto micros = [](chrono::high_resolution_clock::time_point a0, chrono::high_resolution_clock::time_point b0) {
+        return chrono::duration<double, micro>(b0 - a0).count();
+    };
+    const int repeats = 10000;
+    auto t0 = now();
+    for (int r = 0; r < repeats; ++r) futures_strip_adjoint_mode(strip, curve, sigma, price, convexity, price_zero, price_sigma);
+    double strip_us = micros(t0, now()) / repeats;
+
+    const int ticks = 1000;
+    int total_iterations = 0;
+    t0 = now();
+    for (int r = 0; r < ticks; ++r)
+    {
+        for (double& m : market) m += 0.005 * (uniform() - 0.5);      // +/- 0.25bp price moves
+        total_iterations += calibrate_curve_to_strip(strip, sigma, market, calibrated, 1e-10);
+    }
+    double calibration_us = micros(t0, now()) / ticks;
+
+    cout << endl << "Price " << n << " contracts + " << p << " pillar & sigma risk: " << setprecision(2) << strip_us << " us" << endl;
+    cout << "Recalibrate the curve per market tick: " << calibration_us << " us, "
+         << (double)total_iterations / ticks << " Newton iterations per tick" << endl;
+
+    return 0;
+}
@@ -0,0 +1,407 @@
+// This file demo's how to compute carry, roll-down and theta for a swap book over several forward horizons in one pass
+// Horizons are 1D, 1W, 1M and 3M, and at each horizon we age the cashflows, roll fixings off and move the curve.
+
+// Horizon P&L of a swap from today to horizon h is PV(h) + cash received in (0,h] - PV(0), where:
+//   - cashflows paid on or before h are aged out of the swap and counted as cash
+//   - float coupons that fix in (0,h] become known amounts, the fixing depends on the curve scenario
+//   - the curve at h is either
+//       constant forwards: today's forwards are realised, df_h(T) = df(h+T) / df(h)
+//       rolled down:       the zero curve is unchanged in time to maturity, df_h(T) = df(T)
+// Carry is the P&L when forwards are realised, roll-down is the extra P&L when the curve rolls down instead, and
+// theta is the 1D P&L with the curve rolled down.
+
+// Re-running price_swap() from AAD-Swap.cpp for every horizon and scenario rebuilds the aged schedule and
+// re-interpolates the curve for every cashflow, so the cost is 2 x horizons full pricings. Here instead:
+//   - each trade's static data is cached once as a sorted list of cashflows on a day grid, every cashflow is
+//     amount = a + b.(df(start)/df(end) - 1), so fixed coupons, known fixings and projected coupons share one form
+//   - the curve is cached once per curve update as a discount factor table on the same day grid, so a discount
+//     factor at today, at h or at T-h is one table lookup
+//   - one pass over the cashflows prices today and every horizon in both scenarios
+// All horizons for the book then cost a small multiple of one pricing.
+
+#include <cmath>         // for math methods e.g. exp()
+#include <vector>        // for vectors
+#include <string>        // for horizon labels
+#include <algorithm>     // for upper_bound(), sort()
+#include <chrono>        // for timing
+#include <iostream>      // for input/output to console
+#include <iomanip>       // for input/output precision
+using namespace std;
+
+const double days_per_year = 365.0;    // ACT/365 year fractions on a day grid
+
+// Yield Curve
+// -----------
+// Zero rates at pillar times, linearly interpolated with flat extrapolation, df(t) = exp(-z(t).t)
+struct Curve
+{
+    vector<double> pillar_t;    // Pillar times in years
+    vector<double> zero_rate;   // Zero rates in decimal
+};
+
+double curve_df(const Curve& curve, double t)
+{
+    const vector<double>& x = curve.pillar_t;
+    const vector<double>& z = curve.zero_rate;
+    if (t <= x.front()) return exp(-z.front() * t);
+    if (t >= x.back())  return exp(-z.back() * t);
+    size_t k = (upper_bound(x.begin(), x.end(), t) - x.begin()) - 1;
+    double w = (x[k+1] - t) / (x[k+1] - x[k]);
+    return exp(-(w * z[k] + (1.0 - w) * z[k+1]) * t);
+}
+
+// Discount factors for days 0 .. max_day, built once per curve update and shared by every trade and horizon
+vector<double> make_df_table(const Curve& curve, int max_day)
+{
+    vector<double> df(max_day + 1);
+    for (int d = 0; d <= max_day; ++d) df[d] = curve_df(curve, d / days_per_year);
+    return df;
+}
+
+// Swap Trades
+// -----------
+// Single curve swap, annual fixed vs float_days float coupons, dates are days from today (negative in the past)
+struct SwapTrade
+{
+    int payReceive;             // Pay or Receive Fixed: 1 = pay, -1 = receive
+    double notional;            // Swap Notional
+    double fixed_rate;          // Fixed Leg: fixed rate in decimal
+    double float_spread;        // Float Leg: floating spread in decimal
+    int start_day;              // Effective date, may be in the past for seasoned swaps
+    int maturity_years;         // Swap maturity in whole years from the effective date
+    int float_days;             // Float Leg: coupon period in days
+    double current_fixing;      // Float Leg: fixing of the current coupon, set at or before today
+};
+
+// Cached static trade data: cashflow paid on pay_day with amount = a + b.(df(start_day)/df(end_day) - 1)
+// The forward term is only used for float coupons that have not fixed yet (b != 0)
+struct Cashflow
+{
+    int pay_day;
+    int start_day;
+    int end_day;
+    double a;       // Known part: fixed coupon, float spread, or the whole coupon once fixed
+    double b;       // Multiplier of the projected float coupon N.f.tau = N.(df(start)/df(end) - 1)
+};
+
+// Build the cached cashflows of a trade, cashflows paid before today are dropped
+vector<Cashflow> build_cashflows(const SwapTrade& trade)
+{
+    vector<Cashflow> flows;
+    const int end_day = trade.start_day + (int)(trade.maturity_years * days_per_year);
+    const double sign = trade.payReceive;   // PV = payReceive.(fixed - float) as in AAD-Swap.cpp
+
+    // Fixed Leg, annual
+    for (int i = 1; i <= trade.maturity_years; ++i)
+    {
+        int s = trade.start_day + (int)((i - 1) * days_per_year), e = min(end_day, trade.start_day + (int)(i * days_per_year));
+        if (e <= 0) continue;
+        flows.push_back({ e, s, e, sign * trade.notional * trade.fixed_rate * (e - s) / days_per_year, 0.0 });
+    }
+
+    // Float Leg, the current coupon has fixed already, later coupons are projected
+    for (int s = trade.start_day; s < end_day; s += trade.float_days)
+    {
+        int e = min(end_day, s + trade.float_days);
+        if (e <= 0) continue;
+        double tau = (e - s) / days_per_year;
+        if (s <= 0) flows.push_back({ e, s, e, -sign * trade.notional * (trade.current_fixing + trade.float_spread) * tau, 0.0 });
+        else        flows.push_back({ e, s, e, -sign * trade.notional * trade.float_spread * tau, -sign * trade.notional });
+    }
+
+    sort(flows.begin(), flows.end(), [](const Cashflow& x, const Cashflow& y) { return x.pay_day < y.pay_day; });
+    return flows;
+}
+
+// Horizon Engine
+// --------------
+// Per trade results, arrays indexed [trade * num_horizons + h]
+struct HorizonResults
+{
+    vector<int> horizon_days;   // Horizons in days from today, ascending
+    vector<double> pv0;         // Today's PV per trade
+    vector<double> pv_cf;       // Constant forwards: PV at the horizon
+    vector<double> cash_cf;     // Constant forwards: cashflows received in (0,h]
+    vector<double> pv_rd;       // Rolled down: PV at the horizon
+    vector<double> cash_rd;     // Rolled down: cashflows received in (0,h]
+};
+
+// Price every trade today and at every horizon under both curve scenarios in one pass over the cached cashflows
+void horizon_engine( const vector<vector<Cashflow>>& book,  // [IN]: Cached cashflows per trade
+                     const vector<double>& df,              // [IN]: Today's discount factor table by day
+                     HorizonResults& res                    // [IN/OUT]: horizon_days in, results out
+                   )
+{
+    const size_t num_h = res.horizon_days.size();
+    const vector<int>& hd = res.horizon_days;
+    res.pv0.assign(book.size(), 0.0);
+    res.pv_cf.assign(book.size() * num_h, 0.0);
+    res.cash_cf.assign(book.size() * num_h, 0.0);
+    res.pv_rd.assign(book.size() * num_h, 0.0);
+    res.cash_rd.assign(book.size() * num_h, 0.0);
+
+    // Constant forwards discount back to h with 1/df(h), shared by every trade
+    vector<double> inv_df_h(num_h);
+    for (size_t h = 0; h < num_h; ++h) inv_df_h[h] = 1.0 / df[hd[h]];
+
+    for (size_t i = 0; i < book.size(); ++i)
+    {
+        double pv0 = 0.0;
+        double* pv_cf = &res.pv_cf[i * num_h];
+        double* cash_cf = &res.cash_cf[i * num_h];
+        double* pv_rd = &res.pv_rd[i * num_h];
+        double* cash_rd = &res.cash_rd[i * num_h];
+
+        for (const Cashflow& cf : book[i])
+        {
+            // Today, also the amount under constant forwards since today's forwards are realised as fixings
+            double amount0 = cf.a;
+            if (cf.b != 0.0) amount0 += cf.b * (df[cf.start_day] / df[cf.end_day] - 1.0);
+            double pv = amount0 * df[cf.pay_day];
+            pv0 += pv;
+
+            for (size_t h = 0; h < num_h; ++h)
+            {
+                // Constant forwards: df_h(T) = df(T) / df(h)
+                if (cf.pay_day <= hd[h]) cash_cf[h] += amount0;
+                else                     pv_cf[h] += pv;
+
+                // Rolled down: the curve seen at day s >= 0 is today's curve, shifted by s
+                // A coupon that fixes in (0,h] fixes on today's curve over [0, e-s], later coupons project over [s-h, e-h]
+                double amount = cf.a;
+                if (cf.b != 0.0)
+                {
+                    int lag = min(cf.start_day, hd[h]);
+                    amount += cf.b * (df[cf.start_day - lag] / df[cf.end_day - lag] - 1.0);
+                }
+                if (cf.pay_day <= hd[h]) cash_rd[h] += amount;
+                else                     pv_rd[h] += amount * df[cf.pay_day - hd[h]];
+            }
+        }
+        res.pv0[i] = pv0;
+        for (size_t h = 0; h < num_h; ++h) pv_cf[h] *= inv_df_h[h];
+    }
+}
+
+// Reference: the trade aged to the horizon, coupons paid in (0,h] have gone and coupons that reset in (0,h] have a fixing
+// Times are in years from the horizon, unfixed float coupons have fixing = NAN
+struct AgedSwap
+{
+    vector<double> fixed_pay, fixed_amount;                                 // Fixed Leg: payment time and coupon
+    vector<double> float_start, float_end, float_tau, float_fixing;         // Float Leg: accrual period and fixing
+};
+
+// Reference: age the trade to the horizon from its terms, independently of the cached cashflows used by the engine
+void age_swap( const SwapTrade& trade,      // [IN]: Swap trade
+               const Curve& curve,          // [IN]: Today's curve
+               int h,                       // [IN]: Horizon in days
+               bool rolled_down,            // [IN]: Curve scenario: true = rolled down, false = constant forwards
+               AgedSwap& aged,              // [OUT]: Swap as seen at the horizon
+               double& cash                 // [OUT]: Cashflows received in (0,h], signed as the trade's PV
+             )
+{
+    aged = AgedSwap();
+    cash = 0.0;
+    const int end_day = trade.start_day + (int)(trade.maturity_years * days_per_year);
+
+    // Fixed Leg, annual
+    for (int i = 1; i <= trade.maturity_years; ++i)
+    {
+        int s = trade.start_day + (int)((i - 1) * days_per_year), e = min(end_day, trade.start_day + (int)(i * days_per_year));
+        double coupon = trade.notional * trade.fixed_rate * (e - s) / days_per_year;
+        if (e <= 0) continue;                                   // paid before today
+        if (e <= h) { cash += trade.payReceive * coupon; continue; }
+        aged.fixed_pay.push_back((e - h) / days_per_year);
+        aged.fixed_amount.push_back(coupon);
+    }
+
+    // Float Leg, set the fixing of every coupon that resets on or before the horizon
+    for (int s = trade.start_day; s < end_day; s += trade.float_days)
+    {
+        int e = min(end_day, s + trade.float_days);
+        if (e <= 0) continue;
+        double tau = (e - s) / days_per_year;
+        double fixing = NAN;
+        if (s <= 0) fixing = trade.current_fixing;
+        else if (s <= h)
+        {
+            // Rolled down: the curve on the reset date is today's curve, so the fixing is today's spot rate for tau
+            // Constant forwards: the fixing is today's forward rate
+            if (rolled_down) fixing = (1.0 / curve_df(curve, tau) - 1.0) / tau;
+            else             fixing = (curve_df(curve, s / days_per_year) / curve_df(curve, e / days_per_year) - 1.0) / tau;
+        }
+        if (e <= h) { cash -= trade.payReceive * trade.notional * (fixing + trade.float_spread) * tau; continue; }
+        aged.float_start.push_back((s - h) / days_per_year);
+        aged.float_end.push_back((e - h) / days_per_year);
+        aged.float_tau.push_back(tau);
+        aged.float_fixing.push_back(fixing);
+    }
+}
+
+// Reference: price the aged swap at the horizon in the same way as a new swap, projecting unfixed coupons off the horizon curve
+void price_at_horizon( const SwapTrade& trade,      // [IN]: Swap trade
+                       const Curve& curve,          // [IN]: Today's curve
+                       int h,                       // [IN]: Horizon in days
+                       bool rolled_down,            // [IN]: Curve scenario: true = rolled down, false = constant forwards
+                       double& pv,                  // [OUT]: PV at the horizon
+                       double& cash                 // [OUT]: Cashflows received in (0,h]
+                     )
+{
+    AgedSwap aged;
+    age_swap(trade, curve, h, rolled_down, aged, cash);
+
+    // Curve as seen at the horizon, t in years from the horizon
+    const double th = h / days_per_year;
+    auto df_h = [&](double t) {
+        if (rolled_down) return curve_df(curve, t);
+        return curve_df(curve, t + th) / curve_df(curve, th);
+    };
+
+    // Fixed Leg
+    double fixed_leg = 0.0;
+    for (size_t i = 0; i < aged.fixed_pay.size(); ++i)
+        fixed_leg += aged.fixed_amount[i] * df_h(aged.fixed_pay[i]);
+
+    // Float Leg, coupons that reset after the horizon are projected off the horizon curve
+    double float_leg = 0.0;
+    for (size_t i = 0; i < aged.float_start.size(); ++i)
+    {
+        double tau = aged.float_tau[i];
+        double fixing = aged.float_fixing[i];
+        if (std::isnan(fixing))
+            fixing = (df_h(aged.float_start[i]) / df_h(aged.float_end[i]) - 1.0) / tau;
+        float_leg += trade.notional * (fixing + trade.float_spread) * tau * df_h(aged.float_end[i]);
+    }
+
+    pv = trade.payReceive * (fixed_leg - float_leg);
+}
+
+// Simple random number generator, uniform on [0,1)
+unsigned int seed = 12345;
+double uniform()
+{
+    seed = seed * 1664525u + 1013904223u;
+    return (seed >> 8) / 16777216.0;
+}
+
+int main()
+{
+    // 1. Market: upward sloping zero curve
+    Curve curve;
+    curve.pillar_t  = { 0.25, 0.5, 1, 2, 3, 5, 7, 10, 15, 20, 30 };
+    curve.zero_rate = { 0.0430, 0.0420, 0.0400, 0.0380, 0.0370, 0.0365, 0.0370, 0.0380, 0.0390, 0.0395, 0.0390 };
+
+    // 2. Book: seasoned and forward starting swaps with 3M float coupons
+    const size_t num_trades = 10000;
+    vector<SwapTrade> trades(num_trades);
+    int max_day = 0;
+    for (SwapTrade& trade : trades)
+    {
+        trade.payReceive = uniform() < 0.5 ? 1 : -1;
+        trade.notional = 1e6 * (1 + (int)(uniform() * 100));
+        trade.fixed_rate = 0.03 + 0.02 * uniform();
+        trade.float_spread = uniform() < 0.2 ? 0.001 * (int)(uniform() * 5) : 0.0;
+        trade.maturity_years = 1 + (int)(uniform() * 30);
+        trade.start_day = (int)((uniform() - 0.8) * trade.maturity_years * days_per_year);    // mostly seasoned
+        trade.float_days = 91;
+        trade.current_fixing = 0.04 + 0.005 * (uniform() - 0.5);
+        max_day = max(max_day, trade.start_day + (int)(trade.maturity_years * days_per_year) + 1);
+    }
+
+    // 3. Cache static trade data once, and the curve once per curve update
+    vector<vector<Cashflow>> book(num_trades);
+    for (size_t i = 0; i < num_trades; ++i) book[i] = build_cashflows(trades[i]);
+    vector<double> df = make_df_table(curve, max_day);
+
+    // 4. All Horizons in One Pass
+    const vector<string> labels = { "1D", "1W", "1M", "3M" };
+    HorizonResults res;
+    res.horizon_days = { 1, 7, 30, 91 };
+    const size_t num_h = res.horizon_days.size();
+    horizon_engine(book, df, res);
+
+    // 5. Book Carry, Roll-down and Theta
+    double book_pv0 = 0.0;
+    for (double pv : res.pv0) book_pv0 += pv;
+    cout << std::fixed << std::setprecision(2);
+    cout << "Trades: " << num_trades << ", book PV: " << book_pv0 << endl << endl;
+    cout << "Horizon       Carry   Roll-down   Total P&L   Cash received" << endl;
+    double theta = 0.0;
+    for (size_t h = 0; h < num_h; ++h)
+    {
+        double pnl_cf = 0.0, pnl_rd = 0.0, cash = 0.0;
+        for (size_t i = 0; i < num_trades; ++i)
+        {
+            size_t k = i * num_h + h;
+            pnl_cf += res.pv_cf[k] + res.cash_cf[k] - res.pv0[i];
+            pnl_rd += res.pv_rd[k] + res.cash_rd[k] - res.pv0[i];
+            cash += res.cash_rd[k];
+        }
+        if (h == 0) theta = pnl_rd;
+        cout << setw(7) << left << labels[h] << right << setw(12) << pnl_cf << setw(12) << pnl_rd - pnl_cf
+             << setw(12) << pnl_rd << setw(16) << cash << endl;
+    }
+    cout << "Theta (1D, curve rolled down): " << theta << endl;
+
+    // 6. Check against ageing the swap to each horizon, fixing the coupons that reset in (0,h], and re-pricing it from scratch
+    double max_diff = 0.0;
+    for (size_t i = 0; i < num_trades; i += 97)
+    {
+        for (size_t h = 0; h < num_h; ++h)
+        {
+            double pv, cash;
+            size_t k = i * num_h + h;
+            price_at_horizon(trades[i], curve, res.horizon_days[h], false, pv, cash);
+            max_diff = max(max_diff, fabs(pv + cash - res.pv_cf[k] - res.cash_cf[k]));
+            price_at_horizon(trades[i], curve, res.horizon_days[h], true, pv, cash);
+            max_diff = max(max_diff, fabs(pv + cash - res.pv_rd[k] - res.cash_rd[k]));
+        }
+    }
+    cout << endl << "Max difference vs re-pricing the aged swap: " << scientific << setprecision(2) << max_diff << fixed << endl;
+
+    // 7. Timing
+    auto now = []() { return chrono::high_resolution_clock::now(); };
+    auto millis = [](chrono::high_resolution_clock::time_point a, chrono::high_resolution_clock::time_point b) {
+        return chrono::duration<double, milli>(b - a).count();
+    };
+    const int repeats = 20;
+    volatile double sink = 0.0;
+
+    auto t0 = now();
+    for (int r = 0; r < repeats; ++r)      // today's PV only, same cached data
+    {
+        HorizonResults today;
+        horizon_engine(book, df, today);
+        sink = sink + today.pv0[0];
+    }
+    double one_pricing = millis(t0, now()) / repeats;
+
+    t0 = now();
+    for (int r = 0; r < repeats; ++r) { horizon_engine(book, df, res); sink = sink + res.pv0[0]; }
+    double engine = millis(t0, now()) / repeats;
+
+    t0 = now();
+    for (int r = 0; r < repeats; ++r) { vector<double> table = make_df_table(curve, max_day); sink = sink + table.back(); }
+    double table_build = millis(t0, now()) / repeats;
+
+    t0 = now();
+    for (size_t i = 0; i < num_trades; ++i)
+    {
+        for (size_t h = 0; h < num_h; ++h)
+        {
+            double pv, cash;
+            price_at_horizon(trades[i], curve, res.horizon_days[h], false, pv, cash); sink = sink + pv;
+            price_at_horizon(trades[i], curve, res.horizon_days[h], true, pv, cash);  sink = sink + pv;
+        }
+    }
+    double reprice = millis(t0, now());
+
+    cout << endl << "Book PV today only:                      " << setw(8) << one_pricing << " ms" << endl;
+    cout << "Book PV today + " << num_h << " horizons x 2 scenarios: " << setw(8) << engine << " ms ("
+         << engine / one_pricing << "x one pricing)" << endl;
+    cout << "Discount factor table build per curve:   " << setw(8) << table_build << " ms" << endl;
+    cout << "Re-pricing per horizon and scenario:     " << setw(8) << reprice << " ms ("
+         << reprice / engine << "x slower than the engine)" << endl;
+
+    return 0;
+}
@@ -0,0 +1,381 @@
+// This file demo's how to maintain live portfolio risk incrementally as trades are added, amended and cancelled
+// We keep aggregate swap PV, PV01 and bucketed DV01 for a book and only price the trade that changed.
+
+// The pricers in AAD-Swap.cpp price one swap and print the result, so every risk run starts from scratch and
+// revalues the whole book. Intraday, the market moves far less often than the trade flow, so here we keep each
+// trade's risk contribution and the book totals:
+//   - add a trade:    price it once (adjoint mode gives PV and all bucketed DV01s) and add its contribution
+//   - amend a trade:  subtract the old contribution, price the amended trade and add the new contribution
+//   - cancel a trade: subtract its contribution
+// A trade event then costs one swap pricing, a few microseconds, instead of a full book revaluation.
+
+// Adding and subtracting contributions in floating point lets the totals drift by rounding error over many
+// events, so every reconcile_interval events we re-sum the stored contributions from scratch and report the drift.
+// A market move changes every trade, so it triggers a full revaluation.
+
+#include <cmath>         // for math methods e.g. exp()
+#include <vector>        // for vectors
+#include <unordered_map> // for the trade store
+#include <algorithm>     // for upper_bound()
+#include <chrono>        // for timing
+#include <iostream>      // for input/output to console
+#include <iomanip>       // for input/output precision
+using namespace std;
+
+// Yield Curve
+// -----------
+// Zero rates at pillar times, linearly interpolated with flat extrapolation, df(t) = exp(-z(t).t)
+// The pillars are also the DV01 risk buckets
+struct Curve
+{
+    vector<double> pillar_t;    // Pillar times in years
+    vector<double> zero_rate;   // Zero rates in decimal
+};
+
+// Locate t on the curve: z(t) = w.zero_rate[k] + (1-w).zero_rate[k+1]
+void curve_weights(const Curve& curve, double t, size_t& k, double& w)
+{
+    const vector<double>& x = curve.pillar_t;
+    if (t <= x.front()) { k = 0; w = 1.0; return; }
+    if (t >= x.back())  { k = x.size() - 2; w = 0.0; return; }
+    k = (upper_bound(x.begin(), x.end(), t) - x.begin()) - 1;
+    w = (x[k+1] - t) / (x[k+1] - x[k]);
+}
+
+double curve_df(const Curve& curve, double t)
+{
+    size_t k; double w;
+    curve_weights(curve, t, k, w);
+    double z = w * curve.zero_rate[k] + (1.0 - w) * curve.zero_rate[k+1];
+    return exp(-z*t);
+}
+
+// Adjoint of curve_df(): add the discount factor risk df_bar to the pillar zero rate risks
+void curve_df_adjoint(const Curve& curve, double t, double df, double df_bar, vector<double>& zero_rate_bar)
+{
+    size_t k; double w;
+    curve_weights(curve, t, k, w);
+    double z_bar = -t * df * df_bar;    // df = exp(-z.t)
+    zero_rate_bar[k] += w * z_bar;      // z = w.z[k] + (1-w).z[k+1]
+    zero_rate_bar[k+1] += (1.0 - w) * z_bar;
+}
+
+// Swap Trades
+// -----------
+// Single curve swap, the float leg forwards are implied from the curve: f = (df(start)/df(end) - 1) / tau
+struct SwapTrade
+{
+    int payReceive;             // Pay or Receive Fixed: 1 = pay, -1 = receive
+    double notional;            // Swap Notional
+    double fixed_rate;          // Fixed Leg: fixed rate in decimal
+    vector<double> fixed_tau;   // Fixed Leg: fixed coupon accrual year fractions
+    vector<double> fixed_t;     // Fixed Leg: fixed coupon payment time in years
+    double float_spread;        // Float Leg: floating spread in decimal
+    double float_start;         // Float Leg: accrual start time of the first coupon in years
+    vector<double> float_tau;   // Float Leg: float coupon accrual year fractions
+    vector<double> float_t;     // Float Leg: float coupon payment time in years
+};
+
+// Trade risk, also used for the book totals
+struct SwapRisk
+{
+    double pv = 0.0;            // Swap PV
+    double pv01 = 0.0;          // Fixed leg annuity x 1bp, as per price_swap() in AAD-Swap.cpp
+    vector<double> dv01;        // Bucketed DV01: PV change for a 1bp shift of each curve pillar
+};
+
+// Compute the swap PV, PV01 and bucketed DV01 using adjoint mode
+// Forward sweep for the price, then back propagation of swap_pv_bar = 1 to every curve pillar in one pass
+void swap_risk_adjoint_mode( const SwapTrade& trade,  // [IN]: Swap trade
+                             const Curve& curve,      // [IN]: Discount & forward curve
+                             SwapRisk& risk           // [OUT]: Swap PV, PV01 and bucketed DV01
+                           )
+{
+    const double shift_size = 0.0001; // Report risk for a 1bp shift
+    const size_t nf = trade.fixed_t.size(), nl = trade.float_t.size();
+
+    // Forward Sweep for Price
+    // -----------------------
+
+    // STEP 1: Fixed Leg PV
+    vector<double> fixed_df(nf);
+    double fixed_pv = 0.0, fixed_annuity = 0.0;
+    for (size_t i = 0; i < nf; ++i)
+    {
+        fixed_df[i] = curve_df(curve, trade.fixed_t[i]);
+        fixed_pv += trade.notional * trade.fixed_rate * trade.fixed_tau[i] * fixed_df[i];
+        fixed_annuity += trade.notional * trade.fixed_tau[i] * fixed_df[i];
+    }
+
+    // STEP 2: Float Leg PV, N.(f+s).tau.df(end) = N.(df(start) - df(end)) + N.s.tau.df(end)
+    vector<double> float_df(nl + 1);
+    float_df[0] = curve_df(curve, trade.float_start);
+    double float_pv = 0.0;
+    for (size_t j = 0; j < nl; ++j)
+    {
+        float_df[j+1] = curve_df(curve, trade.float_t[j]);
+        float_pv += trade.notional * (float_df[j] - float_df[j+1]) + trade.notional * trade.float_spread * trade.float_tau[j] * float_df[j+1];
+    }
+
+    // STEP 3: Swap PV
+    risk.pv = trade.payReceive * (fixed_pv - float_pv);
+    risk.pv01 = -trade.payReceive * fixed_annuity * shift_size;
+
+    // Back Propagation for Risk
+    // -------------------------
+    double swap_pv_bar = 1.0;
+    vector<double> zero_rate_bar(curve.pillar_t.size(), 0.0);
+
+    // STEP 3. Risk from Swap PV Calculation
+    double fixed_pv_bar = trade.payReceive * swap_pv_bar;
+    double float_pv_bar = -trade.payReceive * swap_pv_bar;
+
+    // STEP 2. Risk from Float Leg PV Calculation
+    for (size_t j = nl; j-- > 0;)
+    {
+        double df_start_bar = trade.notional * float_pv_bar;
+        double df_end_bar = (-trade.notional + trade.notional * trade.float_spread * trade.float_tau[j]) * float_pv_bar;
+        curve_df_adjoint(curve, trade.float_t[j], float_df[j+1], df_end_bar, zero_rate_bar);
+        curve_df_adjoint(curve, j == 0 ? trade.float_start : trade.float_t[j-1], float_df[j], df_start_bar, zero_rate_bar);
+    }
+
+    // STEP 1. Risk from Fixed Leg PV Calculation
+    for (size_t i = nf; i-- > 0;)
+    {
+        double df_bar = trade.notional * trade.fixed_rate * trade.fixed_tau[i] * fixed_pv_bar;
+        curve_df_adjoint(curve, trade.fixed_t[i], fixed_df[i], df_bar, zero_rate_bar);
+    }
+
+    risk.dv01.assign(zero_rate_bar.size(), 0.0);
+    for (size_t k = 0; k < zero_rate_bar.size(); ++k) risk.dv01[k] = zero_rate_bar[k] * shift_size;
+}
+
+// Live Swap Portfolio
+// -------------------
+class SwapPortfolio
+{
+public:
+    SwapPortfolio(const Curve& curve, size_t reconcile_interval)
+        : curve_(curve), reconcile_interval_(reconcile_interval)
+    {
+        total_.dv01.assign(curve.pillar_t.size(), 0.0);
+    }
+
+    // Add a new trade and its risk contribution
+    void add_trade(long id, const SwapTrade& trade)
+    {
+        if (positions_.count(id)) { cout << "Portfolio Error: Trade " << id << " already exists" << endl; return; }
+        Position& position = positions_[id];
+        position.trade = trade;
+        swap_risk_adjoint_mode(position.trade, curve_, position.risk);
+        apply(position.risk, 1.0);
+        on_update();
+    }
+
+    // Replace a trade, e.g. a notional or rate amendment: remove the old contribution and add the new one
+    void amend_trade(long id, const SwapTrade& trade)
+    {
+        auto found = positions_.find(id);
+        if (found == positions_.end()) { cout << "Portfolio Error: Trade " << id << " not found" << endl; return; }
+        apply(found->second.risk, -1.0);
+        found->second.trade = trade;
+        swap_risk_adjoint_mode(found->second.trade, curve_, found->second.risk);
+        apply(found->second.risk, 1.0);
+        on_update();
+    }
+
+    // Remove a trade and its risk contribution
+    void cancel_trade(long id)
+    {
+        auto found = positions_.find(id);
+        if (found == positions_.end()) { cout << "Portfolio Error: Trade " << id << " not found" << endl; return; }
+        apply(found->second.risk, -1.0);
+        positions_.erase(found);
+        on_update();
+    }
+
+    // Market move: every trade contribution changes, so revalue the book in full
+    void set_curve(const Curve& curve)
+    {
+        curve_ = curve;
+        for (auto& entry : positions_) swap_risk_adjoint_mode(entry.second.trade, curve_, entry.second.risk);
+        total_ = resum();                   // the totals from the old curve are not comparable, so no drift check
+        updates_since_reconcile_ = 0;
+    }
+
+    // Re-sum the stored trade contributions from scratch, returns the largest drift found in the running totals
+    double reconcile()
+    {
+        SwapRisk total = resum();
+        double drift = max(fabs(total.pv - total_.pv), fabs(total.pv01 - total_.pv01));
+        for (size_t k = 0; k < total.dv01.size(); ++k) drift = max(drift, fabs(total.dv01[k] - total_.dv01[k]));
+
+        total_ = total;
+        updates_since_reconcile_ = 0;
+        max_drift_ = max(max_drift_, drift);
+        return drift;
+    }
+
+    const SwapRisk& risk() const { return total_; }
+    size_t size() const { return positions_.size(); }
+    double max_drift() const { return max_drift_; }
+
+private:
+    struct Position
+    {
+        SwapTrade trade;
+        SwapRisk risk;
+    };
+
+    // Book totals summed from the stored trade contributions
+    SwapRisk resum() const
+    {
+        SwapRisk total;
+        total.dv01.assign(curve_.pillar_t.size(), 0.0);
+        for (const auto& entry : positions_)
+        {
+            total.pv += entry.second.risk.pv;
+            total.pv01 += entry.second.risk.pv01;
+            for (size_t k = 0; k < total.dv01.size(); ++k) total.dv01[k] += entry.second.risk.dv01[k];
+        }
+        return total;
+    }
+
+    // Add (sign = 1) or remove (sign = -1) a trade contribution from the book totals
+    void apply(const SwapRisk& risk, double sign)
+    {
+        total_.pv += sign * risk.pv;
+        total_.pv01 += sign * risk.pv01;
+        for (size_t k = 0; k < total_.dv01.size(); ++k) total_.dv01[k] += sign * risk.dv01[k];
+    }
+
+    void on_update()
+    {
+        if (++updates_since_reconcile_ >= reconcile_interval_) reconcile();
+    }
+
+    Curve curve_;
+    size_t reconcile_interval_;
+    size_t updates_since_reconcile_ = 0;
+    double max_drift_ = 0.0;
+    unordered_map<long, Position> positions_;
+    SwapRisk total_;
+};
+
+// Build a spot starting swap, annual fixed vs quarterly float, for the given tenor in years
+SwapTrade make_swap(int payReceive, double notional, double fixed_rate, int tenor)
+{
+    SwapTrade trade;
+    trade.payReceive = payReceive;
+    trade.notional = notional;
+    trade.fixed_rate = fixed_rate;
+    trade.float_spread = 0.0;
+    trade.float_start = 0.0;
+    for (int i = 1; i <= tenor; ++i) { trade.fixed_tau.push_back(1.0); trade.fixed_t.push_back(i); }
+    for (int j = 1; j <= 4 * tenor; ++j) { trade.float_tau.push_back(0.25); trade.float_t.push_back(0.25 * j); }
+    return trade;
+}
+
+void display_risk(const string& name, const Curve& curve, const SwapRisk& risk)
+{
+    cout << name << endl;
+    cout << "PV: " << std::fixed << std::setprecision(2) << risk.pv << endl;
+    cout << "PV01: " << std::fixed << std::setprecision(2) << risk.pv01 << endl;
+    cout << "Bucketed DV01:";
+    for (size_t k = 0; k < risk.dv01.size(); ++k) cout << " " << std::setprecision(0) << curve.pillar_t[k] << "Y=" << std::setprecision(2) << risk.dv01[k];
+    cout << endl << endl;
+}
+
+int main()
+{
+    // 1. Market Data: zero curve, the pillars are also the DV01 buckets
+    Curve curve;
+    curve.pillar_t  = { 1.0, 2.0, 3.0, 5.0, 7.0, 10.0, 15.0, 20.0, 30.0 };
+    curve.zero_rate = { 0.030, 0.031, 0.032, 0.034, 0.035, 0.036, 0.037, 0.037, 0.036 };
+
+    const int tenors[] = { 2, 3, 5, 7, 10, 15, 20, 30 };
+    unsigned int seed = 12345;
+    auto uniform = [&seed]() { seed = seed * 1664525u + 1013904223u; return (seed >> 8) / 16777216.0; };
+    auto random_swap = [&]() {
+        return make_swap(uniform() < 0.5 ? 1 : -1, 1000000.0 * (1 + (int)(uniform() * 100)), 0.025 + 0.02 * uniform(), tenors[(int)(uniform() * 8)]);
+    };
+
+    // 2. Start of Day: load the book
+    SwapPortfolio portfolio(curve, 10000);
+    const long book_size = 100000;
+    auto t0 = chrono::steady_clock::now();
+    for (long id = 0; id < book_size; ++id) portfolio.add_trade(id, random_swap());
+    auto t1 = chrono::steady_clock::now();
+
+    cout << "Start of Day: " << portfolio.size() << " trades loaded in " << std::fixed << std::setprecision(1)
+         << chrono::duration<double, milli>(t1 - t0).count() << " ms" << endl;
+    display_risk("Book Risk", curve, portfolio.risk());
+
+    // 3. Intraday Trade Flow: new trades, amendments and cancellations
+    const long events = 100000;
+    long next_id = book_size;
+    long adds = 0, amends = 0, cancels = 0;
+    vector<SwapTrade> flow;
+    vector<double> actions, targets;
+    for (long e = 0; e < events; ++e)
+    {
+        flow.push_back(random_swap());
+        actions.push_back(uniform());
+        targets.push_back(uniform());
+    }
+
+    vector<long> live(book_size);
+    for (long id = 0; id < book_size; ++id) live[id] = id;
+
+    auto t2 = chrono::steady_clock::now();
+    for (long e = 0; e < events; ++e)
+    {
+        size_t pick = (size_t)(targets[e] * live.size());
+        if (actions[e] < 0.5 || live.empty())
+        {
+            portfolio.add_trade(next_id, flow[e]);
+            live.push_back(next_id++);
+            ++adds;
+        }
+        else if (actions[e] < 0.8)
+        {
+            portfolio.cancel_trade(live[pick]);
+            live[pick] = live.back();
+            live.pop_back();
+            ++cancels;
+        }
+        else
+        {
+            portfolio.amend_trade(live[pick], flow[e]);
+            ++amends;
+        }
+    }
+    auto t3 = chrono::steady_clock::now();
+    double drift = portfolio.reconcile();
+
+    cout << "Intraday Flow: " << adds << " adds, " << amends << " amends, " << cancels << " cancels" << endl;
+    cout << "Average update time: " << std::fixed << std::setprecision(2)
+         << chrono::duration<double, micro>(t3 - t2).count() / events << " us per event" << endl;
+    cout << "Reconciliation drift: last " << std::scientific << std::setprecision(2) << drift << ", max " << portfolio.max_drift() << endl;
+    cout << endl;
+    display_risk("Book Risk", curve, portfolio.risk());
+
+    // 4. Market Move: zero rates up 1bp, full revaluation
+    Curve shifted = curve;
+    for (double& z : shifted.zero_rate) z += 0.0001;
+    double pv_before = portfolio.risk().pv;
+    double dv01 = 0.0;
+    for (double d : portfolio.risk().dv01) dv01 += d;
+
+    auto t4 = chrono::steady_clock::now();
+    portfolio.set_curve(shifted);
+    auto t5 = chrono::steady_clock::now();
+
+    cout << "Market Move: full revaluation of " << portfolio.size() << " trades in " << std::fixed << std::setprecision(1)
+         << chrono::duration<double, milli>(t5 - t4).count() << " ms" << endl;
+    cout << "PV change: " << std::fixed << std::setprecision(2) << portfolio.risk().pv - pv_before << " vs DV01: " << dv01 << endl;
+    cout << "Reconciliation drift after the move: " << std::scientific << std::setprecision(2) << portfolio.reconcile()
+         << ", max " << portfolio.max_drift() << endl;
+
+    return 0;
+}
@@ -0,0 +1,368 @@
+// This file demo's how to generate swap schedules, i.e. the coupon accrual year fractions (tau) and payment
+// times (t) that the pricers in AAD-Swap.cpp take as inputs, from the trade dates and conventions.
+
+// In AAD-Swap.cpp the vectors fixed_tau, fixed_t, float_tau and float_t are typed by hand. Here we build them from:
+//   - start date and tenor (swap maturity in months)
+//   - coupon frequency (payments per year)
+//   - roll convention (how to adjust coupon dates that fall on a weekend or holiday)
+//   - business day calendar (weekends + holidays)
+//   - day count convention (ACT/360, ACT/365F, 30/360)
+
+// Swap books hold many trades with the same schedule, e.g. all 5Y swaps starting today. Instead of every trade
+// owning a copy of its schedule, schedules are interned in a shared cache and trades refer to them by a handle.
+// A book of 1,000,000 swaps then only needs a few thousand distinct schedules in memory. This is also good for
+// speed as the discount factors for a schedule can be computed once and shared across trades.
+
+#include <cmath>         // for math methods e.g. exp()
+#include <vector>        // for vectors
+#include <string>        // for strings
+#include <unordered_map> // for the schedule cache
+#include <algorithm>     // for binary_search()
+#include <iostream>      // for input/output to console
+#include <iomanip>       // for input/output precision
+using namespace std;
+
+// Dates
+// -----
+// Dates are held as a serial day number (days since 1970-01-01) so that date differences are integer subtraction.
+typedef int Date;
+
+// Convert a year, month, day into a serial date (proleptic Gregorian calendar)
+Date make_date(int y, int m, int d)
+{
+    y -= m <= 2;
+    int era = (y >= 0 ? y : y - 399) / 400;
+    int yoe = y - era * 400;
+    int doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    int doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + doe - 719468;
+}
+
+// Convert a serial date back into year, month, day
+void split_date(Date date, int& y, int& m, int& d)
+{
+    date += 719468;
+    int era = (date >= 0 ? date : date - 146096) / 146097;
+    int doe = date - era * 146097;
+    int yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    int doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    int mp = (5 * doy + 2) / 153;
+    d = doy - (153 * mp + 2) / 5 + 1;
+    m = mp + (mp < 10 ? 3 : -9);
+    y = yoe + era * 400 + (m <= 2);
+}
+
+bool is_leap_year(int y) { return (y % 4 == 0 && y % 100 != 0) || y % 400 == 0; }
+
+int days_in_month(int y, int m)
+{
+    static const int days[] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+    return (m == 2 && is_leap_year(y)) ? 29 : days[m - 1];
+}
+
+// Add months to a date, the day is capped at the month end e.g. 31-Jan + 1M = 28-Feb
+Date add_months(Date date, int months)
+{
+    int y, m, d;
+    split_date(date, y, m, d);
+    int total = y * 12 + (m - 1) + months;
+    y = total / 12;
+    m = total % 12 + 1;
+    return make_date(y, m, min(d, days_in_month(y, m)));
+}
+
+string date_to_string(Date date)
+{
+    int y, m, d;
+    split_date(date, y, m, d);
+    static const char* names[] = { "Jan", "Feb", "Mar", "Apr", "May", "Jun", "Jul", "Aug", "Sep", "Oct", "Nov", "Dec" };
+    return (d < 10 ? "0" : "") + to_string(d) + "-" + names[m - 1] + "-" + to_string(y);
+}
+
+// Business Day Calendars
+// ----------------------
+// A calendar is a list of holidays, weekends are always non-business days
+struct Calendar
+{
+    string name;             // Calendar name e.g. "USNY"
+    vector<Date> holidays;   // Sorted holiday dates
+};
+
+bool is_business_day(const Calendar& calendar, Date date)
+{
+    int weekday = ((date % 7) + 7 + 3) % 7; // 0 = Monday ... 6 = Sunday, 01-Jan-1970 was a Thursday
+    if (weekday >= 5) return false;
+    return !binary_search(calendar.holidays.begin(), calendar.holidays.end(), date);
+}
+
+// Roll Conventions
+// ----------------
+enum RollConvention { Unadjusted, Following, ModifiedFollowing, Preceding };
+
+Date adjust_date(const Calendar& calendar, Date date, RollConvention roll)
+{
+    if (roll == Unadjusted) return date;
+    Date adjusted = date;
+    if (roll == Preceding)
+    {
+        while (!is_business_day(calendar, adjusted)) --adjusted;
+        return adjusted;
+    }
+    while (!is_business_day(calendar, adjusted)) ++adjusted;
+    if (roll == ModifiedFollowing)
+    {
+        // Roll back if we moved into the next month
+        int y1, m1, d1, y2, m2, d2;
+        split_date(date, y1, m1, d1);
+        split_date(adjusted, y2, m2, d2);
+        if (m1 != m2)
+        {
+            adjusted = date;
+            while (!is_business_day(calendar, adjusted)) --adjusted;
+        }
+    }
+    return adjusted;
+}
+
+// Day Count Conventions
+// ---------------------
+enum DayCount { ACT360, ACT365F, Thirty360 };
+
+double year_fraction(Date start, Date end, DayCount dayCount)
+{
+    if (dayCount == ACT360)  return (end - start) / 360.0;
+    if (dayCount == ACT365F) return (end - start) / 365.0;
+
+    // 30/360 Bond Basis (ISDA)
+    int y1, m1, d1, y2, m2, d2;
+    split_date(start, y1, m1, d1);
+    split_date(end, y2, m2, d2);
+    if (d1 == 31) d1 = 30;
+    if (d2 == 31 && d1 == 30) d2 = 30;
+    return (360.0 * (y2 - y1) + 30.0 * (m2 - m1) + (d2 - d1)) / 360.0;
+}
+
+// Swap Schedules
+// --------------
+// Everything that determines a leg schedule. Two legs with equal specs have identical schedules.
+struct ScheduleSpec
+{
+    Date valuation_date;    // Payment times are measured in years (ACT/365F) from this date
+    Date start_date;        // Accrual start date (unadjusted)
+    int tenor_months;       // Swap maturity in months e.g. 60 = 5Y
+    int frequency;          // Coupons per year: 1 = annual, 2 = semi-annual, 4 = quarterly, 12 = monthly
+    RollConvention roll;    // Business day adjustment of coupon dates
+    int calendar;           // Index of the business day calendar
+    DayCount dayCount;      // Accrual year fraction convention
+
+    bool operator==(const ScheduleSpec& o) const
+    {
+        return valuation_date == o.valuation_date && start_date == o.start_date && tenor_months == o.tenor_months
+            && frequency == o.frequency && roll == o.roll && calendar == o.calendar && dayCount == o.dayCount;
+    }
+};
+
+struct ScheduleSpecHash
+{
+    size_t operator()(const ScheduleSpec& s) const
+    {
+        size_t h = 1469598103934665603ULL;
+        const int fields[] = { s.valuation_date, s.start_date, s.tenor_months, s.frequency, (int)s.roll, s.calendar, (int)s.dayCount };
+        for (int f : fields) { h ^= (size_t)(unsigned)f; h *= 1099511628211ULL; }
+        return h;
+    }
+};
+
+// A generated leg schedule, in the form the swap pricers consume
+struct Schedule
+{
+    vector<Date> payment_dates; // Adjusted coupon payment dates
+    vector<double> tau;         // Coupon accrual year fractions
+    vector<double> t;           // Coupon payment times in years
+};
+
+// Validate a schedule spec, coupon periods must be a whole number of months
+bool valid_schedule_spec(const ScheduleSpec& spec, const vector<Calendar>& calendars)
+{
+    if (spec.frequency <= 0 || 12 % spec.frequency != 0)  { cout << "Schedule Error: Frequency must be 1, 2, 3, 4, 6 or 12" << endl; return false; }
+    if (spec.tenor_months <= 0)                             { cout << "Schedule Error: Tenor must be positive" << endl; return false; }
+    if (spec.calendar < 0 || spec.calendar >= (int)calendars.size()) { cout << "Schedule Error: Unknown calendar" << endl; return false; }
+    return true;
+}
+
+// Generate a schedule forwards from the start date, any broken period is a short final stub
+Schedule generate_schedule(const ScheduleSpec& spec, const vector<Calendar>& calendars)
+{
+    Schedule schedule;
+    if (!valid_schedule_spec(spec, calendars)) return schedule;
+    const Calendar& calendar = calendars[spec.calendar];
+    int step = 12 / spec.frequency;
+    Date maturity = add_months(spec.start_date, spec.tenor_months);
+
+    Date accrual_start = adjust_date(calendar, spec.start_date, spec.roll);
+    for (int months = step; ; months += step)
+    {
+        // Roll from the start date each time so month end days do not drift e.g. 31-Jan, 30-Apr, 31-Jul
+        Date unadjusted_end = months < spec.tenor_months ? add_months(spec.start_date, months) : maturity;
+        Date accrual_end = adjust_date(calendar, unadjusted_end, spec.roll);
+
+        schedule.payment_dates.push_back(accrual_end);
+        schedule.tau.push_back(year_fraction(accrual_start, accrual_end, spec.dayCount));
+        schedule.t.push_back(year_fraction(spec.valuation_date, accrual_end, ACT365F));
+
+        if (months >= spec.tenor_months) break;
+        accrual_start = accrual_end;
+    }
+    return schedule;
+}
+
+// Shared schedule store, identical schedules are generated once and shared by handle
+typedef size_t ScheduleHandle;
+const ScheduleHandle invalid_schedule = (ScheduleHandle)-1;    // Returned for an invalid spec, get() gives an empty schedule
+
+class ScheduleCache
+{
+public:
+    explicit ScheduleCache(const vector<Calendar>& calendars) : calendars_(calendars) {}
+
+    // Return the handle of an existing identical schedule or generate and store a new one
+    ScheduleHandle intern(const ScheduleSpec& spec)
+    {
+        auto found = index_.find(spec);
+        if (found != index_.end()) return found->second;
+        if (!valid_schedule_spec(spec, calendars_)) return invalid_schedule;
+        ScheduleHandle handle = schedules_.size();
+        schedules_.push_back(generate_schedule(spec, calendars_));
+        index_.emplace(spec, handle);
+        return handle;
+    }
+
+    const Schedule& get(ScheduleHandle handle) const
+    {
+        static const Schedule empty;
+        return handle < schedules_.size() ? schedules_[handle] : empty;
+    }
+    size_t size() const { return schedules_.size(); }
+
+private:
+    vector<Calendar> calendars_;    // Own copy, only a handful of calendars
+    vector<Schedule> schedules_;
+    unordered_map<ScheduleSpec, ScheduleHandle, ScheduleSpecHash> index_;
+};
+
+// Swap Trades
+// -----------
+// Trades hold schedule handles rather than their own copies of tau and t
+struct SwapTrade
+{
+    int payReceive;                 // Pay or Receive Fixed: 1 = pay, -1 = receive
+    double notional;                // Swap Notional
+    double fixed_rate;              // Fixed Leg: fixed rate in decimal
+    ScheduleHandle fixed_schedule;  // Fixed Leg: schedule handle
+    double float_spread;            // Float Leg: floating spread in decimal
+    ScheduleHandle float_schedule;  // Float Leg: schedule handle
+};
+
+// Compute the swap present value, as per price_swap() in AAD-Swap.cpp but reading the schedules from the cache
+// For simplicity we assume df=exp(-z.t) given a constant zero rate z and a flat forward rate for all float coupons
+double price_swap( const SwapTrade& trade,          // [IN]: Swap trade
+                   const ScheduleCache& schedules,  // [IN]: Shared schedule cache
+                   double float_rate,               // [IN]: Float Leg: floating forward rate in decimal
+                   double zero_rate                 // [IN]: Discounting zero rate in decimal
+                 )
+{
+    const Schedule& fixed = schedules.get(trade.fixed_schedule);
+    const Schedule& flt = schedules.get(trade.float_schedule);
+
+    // Fixed Leg PV
+    double fixed_pv = 0.0;
+    for (size_t i = 0; i < fixed.t.size(); ++i)
+    {
+        fixed_pv += trade.notional * trade.fixed_rate * fixed.tau[i] * exp(-zero_rate*fixed.t[i]);
+    }
+
+    // Float Leg PV
+    double float_pv = 0.0;
+    for (size_t j = 0; j < flt.t.size(); ++j)
+    {
+        float_pv += trade.notional * (float_rate + trade.float_spread) * flt.tau[j] * exp(-zero_rate*flt.t[j]);
+    }
+
+    // Swap PV
+    return trade.payReceive * (fixed_pv - float_pv);
+}
+
+void display_schedule(const string& name, const Schedule& schedule)
+{
+    cout << name << endl;
+    cout << "  Payment Date    tau       t" << endl;
+    for (size_t i = 0; i < schedule.t.size(); ++i)
+    {
+        cout << "  " << date_to_string(schedule.payment_dates[i]) << "    " << std::fixed << std::setprecision(6)
+             << schedule.tau[i] << "  " << schedule.t[i] << endl;
+    }
+    cout << endl;
+}
+
+int main()
+{
+    // 1. Business Day Calendars
+    vector<Calendar> calendars(1);
+    calendars[0].name = "USNY";
+    calendars[0].holidays = { make_date(2024, 1, 1),  make_date(2024, 5, 27), make_date(2024, 7, 4),
+                              make_date(2024, 12, 25), make_date(2025, 1, 1),  make_date(2025, 5, 26),
+                              make_date(2025, 7, 4),  make_date(2025, 12, 25), make_date(2026, 1, 1),
+                              make_date(2026, 5, 25), make_date(2026, 12, 25), make_date(2027, 1, 1),
+                              make_date(2028, 12, 25), make_date(2029, 1, 1) };
+    int USNY = 0;
+
+    ScheduleCache schedules(calendars);
+    Date today = make_date(2024, 1, 29);
+
+    // 2. Swap Specification
+    // Receive Annual Fixed 5% (30/360) vs Annual LIBOR Flat (ACT/360) for 5 years, as per AAD-Swap.cpp
+    ScheduleSpec fixed_spec = { today, make_date(2024, 1, 31), 60, 1, ModifiedFollowing, USNY, Thirty360 };
+    ScheduleSpec float_spec = { today, make_date(2024, 1, 31), 60, 1, ModifiedFollowing, USNY, ACT360 };
+
+    SwapTrade swap = { 1, 1000000, 0.05, schedules.intern(fixed_spec), 0.0, schedules.intern(float_spec) };
+
+    cout << "Swap Specification" << endl;
+    cout << "5Y IRS: USD 1,000,000 Receive Fixed 5% vs LIBOR Flat, Start " << date_to_string(fixed_spec.start_date) << endl;
+    cout << endl;
+    display_schedule("Fixed Leg Schedule (Annual, 30/360, Modified Following)", schedules.get(swap.fixed_schedule));
+    display_schedule("Float Leg Schedule (Annual, ACT/360, Modified Following)", schedules.get(swap.float_schedule));
+
+    double zero_rate = 0.015;   // Zero Rate, 1.5%
+    double float_rate = 0.01;   // LIBOR Rate, 1.0%
+    cout << "Swap PV: " << std::fixed << std::setprecision(2) << price_swap(swap, schedules, float_rate, zero_rate) << endl;
+    cout << endl;
+
+    // 3. Swap Book: 1,000,000 trades over a year of start dates and standard tenors
+    // Fixed legs are annual 30/360 and float legs quarterly ACT/360
+    const int tenors[] = { 12, 24, 36, 60, 84, 120, 180, 240, 360 };
+    const size_t book_size = 1000000;
+    vector<SwapTrade> book;
+    book.reserve(book_size);
+
+    unsigned int seed = 12345;
+    for (size_t k = 0; k < book_size; ++k)
+    {
+        seed = seed * 1664525u + 1013904223u;               // simple LCG to spread trades over the spec grid
+        Date start = today + (int)((seed >> 8) % 365);
+        int tenor = tenors[(seed >> 4) % 9];
+        ScheduleSpec fixed_leg = { today, start, tenor, 1, ModifiedFollowing, USNY, Thirty360 };
+        ScheduleSpec float_leg = { today, start, tenor, 4, ModifiedFollowing, USNY, ACT360 };
+        SwapTrade trade = { (k % 2) ? 1 : -1, 1000000, 0.04, schedules.intern(fixed_leg), 0.0, schedules.intern(float_leg) };
+        book.push_back(trade);
+    }
+
+    double book_pv = 0.0;
+    for (const SwapTrade& trade : book) book_pv += price_swap(trade, schedules, float_rate, zero_rate);
+
+    cout << "Swap Book" << endl;
+    cout << "Trades: " << book.size() << endl;
+    cout << "Distinct schedules in cache: " << schedules.size() << endl;
+    cout << "Book PV: " << std::fixed << std::setprecision(2) << book_pv << endl;
+
+    return 0;
+}
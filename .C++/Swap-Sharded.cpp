@@ -0,0 +1,498 @@
+// This file demo's how to shard a swap risk run across local worker processes, one per NUMA node
+// Each worker is pinned to its node's CPUs, prices its shard with the swap adjoint and writes bucketed risk to shared
+// memory. A coordinator restarts failed shards and reduces the results deterministically. Linux only.
+
+// A single multithreaded process stops scaling on a large book: the trades are allocated by whichever thread built
+// them so most threads read remote NUMA memory, and one heap serves every thread so it fragments. Here instead:
+//   - the book is cut into fixed blocks of trades, and each shard owns a contiguous range of blocks
+//   - each shard runs in its own process (fork) pinned to one NUMA node (sched_setaffinity), so it builds its trades
+//     in node local memory with its own heap, then prices them with one thread per CPU of the node
+//   - each block's PV and bucketed DV01 go to that block's slot in a shared memory segment (mmap), followed by a done
+//     flag, so a worker that dies mid-block never leaves a partial result
+//   - the coordinator waits for the workers, relaunches a shard whose worker failed for its unfinished blocks only,
+//     then sums the block slots in block order
+// Block sums depend only on the trades in the block, so the totals are bit-for-bit identical for any number of
+// shards, threads or restarts, and identical to the single process run.
+
+// NUMA nodes are read from /sys/devices/system/node, a machine without that directory is treated as one node.
+// Trades are generated from their trade id, standing in for loading each shard's trades from the trade store.
+
+#include <cmath>         // for math methods e.g. exp()
+#include <vector>        // for vectors
+#include <string>        // for sysfs paths
+#include <fstream>       // for reading the NUMA topology
+#include <sstream>       // for parsing CPU lists
+#include <algorithm>     // for upper_bound()
+#include <cstring>       // for memcpy()
+#include <new>           // for placement new of the done flags
+#include <thread>        // for threads inside a worker and the single process run
+#include <atomic>        // for block done flags and handing out blocks
+#include <chrono>        // for timing
+#include <iostream>      // for input/output to console
+#include <iomanip>       // for input/output precision
+#include <sched.h>       // for sched_setaffinity()
+#include <sys/mman.h>    // for mmap()
+#include <sys/wait.h>    // for waitpid()
+#include <unistd.h>      // for fork(), _exit()
+using namespace std;
+
+// Yield Curve
+// -----------
+// Zero rates at pillar times, linearly interpolated with flat extrapolation, df(t) = exp(-z(t).t)
+// The pillars are also the DV01 risk buckets
+struct Curve
+{
+    vector<double> pillar_t;    // Pillar times in years
+    vector<double> zero_rate;   // Zero rates in decimal
+};
+
+// Locate t on the curve: z(t) = w.zero_rate[k] + (1-w).zero_rate[k+1]
+void curve_weights(const Curve& curve, double t, size_t& k, double& w)
+{
+    const vector<double>& x = curve.pillar_t;
+    if (t <= x.front()) { k = 0; w = 1.0; return; }
+    if (t >= x.back())  { k = x.size() - 2; w = 0.0; return; }
+    k = (upper_bound(x.begin(), x.end(), t) - x.begin()) - 1;
+    w = (x[k+1] - t) / (x[k+1] - x[k]);
+}
+
+double curve_df(const Curve& curve, double t)
+{
+    size_t k; double w;
+    curve_weights(curve, t, k, w);
+    double z = w * curve.zero_rate[k] + (1.0 - w) * curve.zero_rate[k+1];
+    return exp(-z*t);
+}
+
+// Adjoint of curve_df(): add the discount factor risk df_bar to the pillar zero rate risks
+void curve_df_adjoint(const Curve& curve, double t, double df, double df_bar, vector<double>& zero_rate_bar)
+{
+    size_t k; double w;
+    curve_weights(curve, t, k, w);
+    double z_bar = -t * df * df_bar;    // df = exp(-z.t)
+    zero_rate_bar[k] += w * z_bar;      // z = w.z[k] + (1-w).z[k+1]
+    zero_rate_bar[k+1] += (1.0 - w) * z_bar;
+}
+
+// Swap Trades
+// -----------
+// Single curve swap, the float leg forwards are implied from the curve: f = (df(start)/df(end) - 1) / tau
+struct SwapTrade
+{
+    int payReceive;             // Pay or Receive Fixed: 1 = pay, -1 = receive
+    double notional;            // Swap Notional
+    double fixed_rate;          // Fixed Leg: fixed rate in decimal
+    vector<double> fixed_tau;   // Fixed Leg: fixed coupon accrual year fractions
+    vector<double> fixed_t;     // Fixed Leg: fixed coupon payment time in years
+    double float_spread;        // Float Leg: floating spread in decimal
+    double float_start;         // Float Leg: accrual start time of the first coupon in years
+    vector<double> float_tau;   // Float Leg: float coupon accrual year fractions
+    vector<double> float_t;     // Float Leg: float coupon payment time in years
+};
+
+// Trade risk, also used for the book totals
+struct SwapRisk
+{
+    double pv = 0.0;            // Swap PV
+    double pv01 = 0.0;          // Fixed leg annuity x 1bp, as per price_swap() in AAD-Swap.cpp
+    vector<double> dv01;        // Bucketed DV01: PV change for a 1bp shift of each curve pillar
+};
+
+// Compute the swap PV, PV01 and bucketed DV01 using adjoint mode
+// Forward sweep for the price, then back propagation of swap_pv_bar = 1 to every curve pillar in one pass
+void swap_risk_adjoint_mode( const SwapTrade& trade,  // [IN]: Swap trade
+                             const Curve& curve,      // [IN]: Discount & forward curve
+                             SwapRisk& risk           // [OUT]: Swap PV, PV01 and bucketed DV01
+                           )
+{
+    const double shift_size = 0.0001; // Report risk for a 1bp shift
+    const size_t nf = trade.fixed_t.size(), nl = trade.float_t.size();
+
+    // Forward Sweep for Price
+    // -----------------------
+
+    // STEP 1: Fixed Leg PV
+    vector<double> fixed_df(nf);
+    double fixed_pv = 0.0, fixed_annuity = 0.0;
+    for (size_t i = 0; i < nf; ++i)
+    {
+        fixed_df[i] = curve_df(curve, trade.fixed_t[i]);
+        fixed_pv += trade.notional * trade.fixed_rate * trade.fixed_tau[i] * fixed_df[i];
+        fixed_annuity += trade.notional * trade.fixed_tau[i] * fixed_df[i];
+    }
+
+    // STEP 2: Float Leg PV, N.(f+s).tau.df(end) = N.(df(start) - df(end)) + N.s.tau.df(end)
+    vector<double> float_df(nl + 1);
+    float_df[0] = curve_df(curve, trade.float_start);
+    double float_pv = 0.0;
+    for (size_t j = 0; j < nl; ++j)
+    {
+        float_df[j+1] = curve_df(curve, trade.float_t[j]);
+        float_pv += trade.notional * (float_df[j] - float_df[j+1]) + trade.notional * trade.float_spread * trade.float_tau[j] * float_df[j+1];
+    }
+
+    // STEP 3: Swap PV
+    risk.pv = trade.payReceive * (fixed_pv - float_pv);
+    risk.pv01 = -trade.payReceive * fixed_annuity * shift_size;
+
+    // Back Propagation for Risk
+    // -------------------------
+    double swap_pv_bar = 1.0;
+    vector<double> zero_rate_bar(curve.pillar_t.size(), 0.0);
+
+    // STEP 3. Risk from Swap PV Calculation
+    double fixed_pv_bar = trade.payReceive * swap_pv_bar;
+    double float_pv_bar = -trade.payReceive * swap_pv_bar;
+
+    // STEP 2. Risk from Float Leg PV Calculation
+    for (size_t j = nl; j-- > 0;)
+    {
+        double df_start_bar = trade.notional * float_pv_bar;
+        double df_end_bar = (-trade.notional + trade.notional * trade.float_spread * trade.float_tau[j]) * float_pv_bar;
+        curve_df_adjoint(curve, trade.float_t[j], float_df[j+1], df_end_bar, zero_rate_bar);
+        curve_df_adjoint(curve, j == 0 ? trade.float_start : trade.float_t[j-1], float_df[j], df_start_bar, zero_rate_bar);
+    }
+
+    // STEP 1. Risk from Fixed Leg PV Calculation
+    for (size_t i = nf; i-- > 0;)
+    {
+        double df_bar = trade.notional * trade.fixed_rate * trade.fixed_tau[i] * fixed_pv_bar;
+        curve_df_adjoint(curve, trade.fixed_t[i], fixed_df[i], df_bar, zero_rate_bar);
+    }
+
+    risk.dv01.assign(zero_rate_bar.size(), 0.0);
+    for (size_t k = 0; k < zero_rate_bar.size(); ++k) risk.dv01[k] = zero_rate_bar[k] * shift_size;
+}
+
+// Book
+// ----
+// Trade id -> swap, each trade has its own random stream so any process can build any trade
+SwapTrade make_trade(long id)
+{
+    unsigned int s = (unsigned int)id * 2654435761u + 12345u;
+    auto uniform = [&s]() { s = s * 1664525u + 1013904223u; return (s >> 8) / 16777216.0; };
+
+    SwapTrade trade;
+    int years = 1 + (int)(uniform() * 30);
+    trade.payReceive = uniform() < 0.5 ? 1 : -1;
+    trade.notional = 1e6 * (1 + (int)(uniform() * 100));
+    trade.fixed_rate = 0.02 + 0.03 * uniform();
+    trade.float_spread = 0.0;
+    trade.float_start = 0.0;
+    for (int i = 1; i <= years; ++i)     { trade.fixed_tau.push_back(1.0); trade.fixed_t.push_back(i); }
+    for (int j = 1; j <= 4 * years; ++j) { trade.float_tau.push_back(0.25); trade.float_t.push_back(0.25 * j); }
+    return trade;
+}
+
+// Risk of one block of trades, summed in trade order: out = { pv, dv01[0], .., dv01[p-1] }
+void block_risk(const SwapTrade* trades, size_t count, const Curve& curve, double* out)
+{
+    const size_t p = curve.pillar_t.size();
+    fill(out, out + 1 + p, 0.0);
+    SwapRisk risk;
+    for (size_t i = 0; i < count; ++i)
+    {
+        swap_risk_adjoint_mode(trades[i], curve, risk);
+        out[0] += risk.pv;
+        for (size_t k = 0; k < p; ++k) out[1 + k] += risk.dv01[k];
+    }
+}
+
+// NUMA Topology
+// -------------
+// Parse a sysfs CPU list e.g. "0-3,8-11"
+vector<int> parse_cpu_list(const string& text)
+{
+    vector<int> cpus;
+    stringstream ss(text);
+    string range;
+    while (getline(ss, range, ','))
+    {
+        if (range.empty() || range == "\n") continue;
+        size_t dash = range.find('-');
+        int first = stoi(range.substr(0, dash));
+        int last = dash == string::npos ? first : stoi(range.substr(dash + 1));
+        for (int c = first; c <= last; ++c) cpus.push_back(c);
+    }
+    return cpus;
+}
+
+// CPUs of each NUMA node that this process may run on
+vector<vector<int>> numa_nodes()
+{
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    sched_getaffinity(0, sizeof(allowed), &allowed);
+
+    vector<vector<int>> nodes;
+    for (int node = 0; ; ++node)
+    {
+        ifstream file("/sys/devices/system/node/node" + to_string(node) + "/cpulist");
+        if (!file) break;
+        string text;
+        getline(file, text);
+        vector<int> cpus;
+        for (int c : parse_cpu_list(text)) if (CPU_ISSET(c, &allowed)) cpus.push_back(c);
+        if (!cpus.empty()) nodes.push_back(cpus);
+    }
+    if (nodes.empty())
+    {
+        vector<int> cpus;
+        for (int c = 0; c < CPU_SETSIZE; ++c) if (CPU_ISSET(c, &allowed)) cpus.push_back(c);
+        nodes.push_back(cpus);
+    }
+    return nodes;
+}
+
+// Shared Memory Results
+// ---------------------
+// One slot of 1 + num_pillars doubles per block, and a done flag per block, in an anonymous shared mapping that
+// survives fork() so every worker and the coordinator see the same pages
+struct SharedResults
+{
+    size_t num_blocks = 0;
+    size_t slot_size = 0;
+    atomic<int>* done = nullptr;
+    double* values = nullptr;
+    void* base = nullptr;
+    size_t bytes = 0;
+};
+
+bool create_shared_results(size_t num_blocks, size_t num_pillars, SharedResults& shared)
+{
+    shared.num_blocks = num_blocks;
+    shared.slot_size = 1 + num_pillars;
+    size_t flag_bytes = (num_blocks * sizeof(atomic<int>) + 63) / 64 * 64;
+    shared.bytes = flag_bytes + num_blocks * shared.slot_size * sizeof(double);
+    shared.base = mmap(nullptr, shared.bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (shared.base == MAP_FAILED) { cout << "Shared Memory Error: mmap failed" << endl; return false; }
+    shared.done = new (shared.base) atomic<int>[num_blocks];
+    for (size_t b = 0; b < num_blocks; ++b) shared.done[b].store(0);
+    shared.values = (double*)((char*)shared.base + flag_bytes);
+    return true;
+}
+
+void destroy_shared_results(SharedResults& shared)
+{
+    if (shared.base) munmap(shared.base, shared.bytes);
+    shared.base = nullptr;
+}
+
+// Sharded Risk Run
+// ----------------
+struct Shard
+{
+    size_t first_block;         // Blocks [first_block, last_block) of the book
+    size_t last_block;
+    vector<int> cpus;           // CPUs the worker is pinned to
+};
+
+// Worker process: pin, build the shard's unfinished blocks in local memory, price them on one thread per CPU
+// fail_after >= 0 simulates a crash after that many blocks, e.g. the worker being killed for memory
+void run_worker(const Shard& shard, size_t block_size, size_t num_trades, const Curve& curve, SharedResults& shared, int fail_after)
+{
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int c : shard.cpus) CPU_SET(c, &set);
+    sched_setaffinity(0, sizeof(set), &set);
+
+    vector<size_t> blocks;
+    for (size_t b = shard.first_block; b < shard.last_block; ++b) if (!shared.done[b].load(memory_order_acquire)) blocks.push_back(b);
+
+    vector<vector<SwapTrade>> trades(blocks.size());
+    for (size_t i = 0; i < blocks.size(); ++i)
+        for (size_t id = blocks[i] * block_size; id < min(num_trades, (blocks[i] + 1) * block_size); ++id) trades[i].push_back(make_trade((long)id));
+
+    atomic<size_t> next(0);
+    atomic<int> completed(0);
+    auto worker = [&]() {
+        vector<double> slot(shared.slot_size);
+        for (size_t i = next++; i < blocks.size(); i = next++)
+        {
+            block_risk(trades[i].data(), trades[i].size(), curve, slot.data());
+            memcpy(shared.values + blocks[i] * shared.slot_size, slot.data(), shared.slot_size * sizeof(double));
+            shared.done[blocks[i]].store(1, memory_order_release);
+            if (fail_after >= 0 && ++completed >= fail_after) _exit(3);
+        }
+    };
+    vector<thread> threads;
+    for (size_t i = 1; i < shard.cpus.size(); ++i) threads.emplace_back(worker);
+    worker();
+    for (thread& t : threads) t.join();
+    _exit(0);
+}
+
+// Coordinator: fork one worker per shard, relaunch failed shards, then reduce the blocks in block order
+bool sharded_risk_run( size_t num_trades,               // [IN]: Trades in the book
+                       size_t block_size,               // [IN]: Trades per block
+                       const Curve& curve,              // [IN]: Discount & forward curve
+                       const vector<Shard>& shards,     // [IN]: Shards and their CPUs
+                       int max_restarts,                // [IN]: Relaunches allowed per shard
+                       int fail_shard,                  // [IN]: Shard whose first worker crashes half way, -1 for none
+                       SwapRisk& book,                  // [OUT]: Book PV and bucketed DV01
+                       int& restarts                    // [OUT]: Number of worker relaunches
+                     )
+{
+    const size_t num_blocks = (num_trades + block_size - 1) / block_size, p = curve.pillar_t.size();
+    SharedResults shared;
+    if (!create_shared_results(num_blocks, p, shared)) return false;
+
+    vector<pid_t> pids(shards.size(), -1);
+    vector<int> attempts(shards.size(), 0);
+    restarts = 0;
+    auto launch = [&](size_t s) {
+        int fail_after = ((int)s == fail_shard && attempts[s] == 0) ? (int)((shards[s].last_block - shards[s].first_block) / 2) : -1;
+        ++attempts[s];
+        cout.flush();       // do not duplicate buffered output in the child
+        pid_t pid = fork();
+        if (pid == 0) run_worker(shards[s], block_size, num_trades, curve, shared, fail_after);
+        pids[s] = pid;
+        return pid > 0;
+    };
+    size_t running = 0;
+    for (size_t s = 0; s < shards.size(); ++s)
+    {
+        if (!launch(s)) { cout << "Shard Error: fork failed" << endl; destroy_shared_results(shared); return false; }
+        ++running;
+    }
+
+    bool ok = true;
+    while (running > 0)
+    {
+        int status = 0;
+        pid_t pid = waitpid(-1, &status, 0);
+        if (pid < 0) break;
+        size_t s = find(pids.begin(), pids.end(), pid) - pids.begin();
+        if (s == pids.size()) continue;
+        --running;
+
+        bool finished = true;
+        for (size_t b = shards[s].first_block; b < shards[s].last_block; ++b) finished = finished && shared.done[b].load(memory_order_acquire);
+        if (WIFEXITED(status) && WEXITSTATUS(status) == 0 && finished) continue;
+
+        if (attempts[s] > max_restarts) { cout << "Shard Error: shard " << s << " failed " << attempts[s] << " times" << endl; ok = false; continue; }
+        ++restarts;
+        if (launch(s)) ++running;
+        else { cout << "Shard Error: fork failed" << endl; ok = false; }
+    }
+
+    // Deterministic reduction in block order
+    book.pv = 0.0;
+    book.pv01 = 0.0;
+    book.dv01.assign(p, 0.0);
+    for (size_t b = 0; b < num_blocks && ok; ++b)
+    {
+        if (!shared.done[b].load(memory_order_acquire)) { cout << "Shard Error: block " << b << " has no result" << endl; ok = false; break; }
+        const double* slot = shared.values + b * shared.slot_size;
+        book.pv += slot[0];
+        for (size_t k = 0; k < p; ++k) book.dv01[k] += slot[1 + k];
+    }
+    destroy_shared_results(shared);
+    return ok;
+}
+
+// Split the book's blocks over num_shards shards, shard s runs on NUMA node s % nodes and the shards on one node
+// share out its CPUs
+vector<Shard> make_shards(size_t num_blocks, size_t num_shards, const vector<vector<int>>& nodes)
+{
+    vector<Shard> shards(num_shards);
+    for (size_t s = 0; s < num_shards; ++s)
+    {
+        shards[s].first_block = s * num_blocks / num_shards;
+        shards[s].last_block = (s + 1) * num_blocks / num_shards;
+        const vector<int>& cpus = nodes[s % nodes.size()];
+        size_t per_node = (num_shards - s % nodes.size() + nodes.size() - 1) / nodes.size();     // shards on this node
+        size_t slot = s / nodes.size();
+        if (cpus.size() < per_node) shards[s].cpus = cpus;
+        else for (size_t c = slot; c < cpus.size(); c += per_node) shards[s].cpus.push_back(cpus[c]);
+    }
+    return shards;
+}
+
+// Single process run for comparison: one thread builds the book, every CPU prices blocks, same block reduction
+void single_process_risk_run(size_t num_trades, size_t block_size, const Curve& curve, unsigned num_threads, SwapRisk& book)
+{
+    const size_t num_blocks = (num_trades + block_size - 1) / block_size, p = curve.pillar_t.size();
+    vector<SwapTrade> trades;
+    trades.reserve(num_trades);
+    for (size_t id = 0; id < num_trades; ++id) trades.push_back(make_trade((long)id));
+
+    vector<double> values(num_blocks * (1 + p));
+    atomic<size_t> next(0);
+    auto worker = [&]() {
+        for (size_t b = next++; b < num_blocks; b = next++)
+            block_risk(&trades[b * block_size], min(block_size, num_trades - b * block_size), curve, &values[b * (1 + p)]);
+    };
+    vector<thread> threads;
+    for (unsigned i = 1; i < num_threads; ++i) threads.emplace_back(worker);
+    worker();
+    for (thread& t : threads) t.join();
+
+    book.pv = 0.0;
+    book.pv01 = 0.0;
+    book.dv01.assign(p, 0.0);
+    for (size_t b = 0; b < num_blocks; ++b)
+    {
+        book.pv += values[b * (1 + p)];
+        for (size_t k = 0; k < p; ++k) book.dv01[k] += values[b * (1 + p) + 1 + k];
+    }
+}
+
+bool identical(const SwapRisk& x, const SwapRisk& y)
+{
+    return x.pv == y.pv && x.dv01 == y.dv01;
+}
+
+int main()
+{
+    // 1. Market Data
+    Curve curve;
+    curve.pillar_t  = { 0.25, 0.5, 1, 2, 3, 5, 7, 10, 15, 20, 30 };
+    curve.zero_rate = { 0.0430, 0.0420, 0.0400, 0.0380, 0.0370, 0.0365, 0.0370, 0.0380, 0.0390, 0.0395, 0.0390 };
+
+    // 2. Book and Machine
+    const size_t num_trades = 200000, block_size = 1000;
+    const size_t num_blocks = (num_trades + block_size - 1) / block_size;
+    vector<vector<int>> nodes = numa_nodes();
+    unsigned num_cpus = 0;
+    for (const vector<int>& cpus : nodes) num_cpus += (unsigned)cpus.size();
+
+    cout << std::fixed << std::setprecision(2);
+    cout << "Trades: " << num_trades << ", blocks: " << num_blocks << ", NUMA nodes: " << nodes.size() << ", CPUs: " << num_cpus << endl;
+
+    auto now = []() { return chrono::high_resolution_clock::now(); };
+    auto millis = [](chrono::high_resolution_clock::time_point a, chrono::high_resolution_clock::time_point b) {
+        return chrono::duration<double, milli>(b - a).count();
+    };
+
+    // 3. Single Process, all CPUs
+    SwapRisk single;
+    auto t0 = now();
+    single_process_risk_run(num_trades, block_size, curve, num_cpus, single);
+    double single_ms = millis(t0, now());
+
+    // 4. Sharded: one worker process per NUMA node
+    SwapRisk sharded;
+    int restarts = 0;
+    t0 = now();
+    bool ok = sharded_risk_run(num_trades, block_size, curve, make_shards(num_blocks, nodes.size(), nodes), 2, -1, sharded, restarts);
+    double sharded_ms = millis(t0, now());
+
+    // 5. Sharded with 4 workers, the first worker of shard 1 crashes half way through its blocks
+    SwapRisk recovered;
+    int recovered_restarts = 0;
+    t0 = now();
+    ok = sharded_risk_run(num_trades, block_size, curve, make_shards(num_blocks, 4, nodes), 2, 1, recovered, recovered_restarts) && ok;
+    double recovered_ms = millis(t0, now());
+    if (!ok) return 1;
+
+    cout << endl << "Book PV: " << single.pv << endl << "Bucketed DV01:";
+    for (size_t k = 0; k < curve.pillar_t.size(); ++k) cout << " " << curve.pillar_t[k] << "Y=" << single.dv01[k];
+    cout << endl << endl;
+    cout << "Single process, " << num_cpus << " threads:                 " << setw(9) << single_ms << " ms" << endl;
+    cout << "Sharded, " << nodes.size() << " worker(s), one per NUMA node:       " << setw(9) << sharded_ms << " ms, restarts: " << restarts << endl;
+    cout << "Sharded, 4 workers, one crash injected:      " << setw(9) << recovered_ms << " ms, restarts: " << recovered_restarts << endl;
+    cout << "Results identical across all runs: " << (identical(single, sharded) && identical(single, recovered) ? "yes" : "no") << endl;
+
+    return 0;
+}